@@ -8,207 +8,280 @@ BYTETracker::BYTETracker(int frame_rate, int track_buffer) {
 
     frame_id = 0;
     max_time_lost = int(frame_rate / 30.0 * track_buffer);
+    num_threads = 1;
+    dense_max_pairs = 64 * 64;
+    shared_track_ids = nullptr;
 }
 
 BYTETracker::~BYTETracker() {
 }
 
 std::vector<STrack> BYTETracker::update(const std::vector<Object> &objects) {
+    update_tracks(objects);
 
-    ////////////////// Step 1: Get detections //////////////////
-    this->frame_id++;
-    std::vector<STrack> activated_stracks;
-    std::vector<STrack> refind_stracks;
-    std::vector<STrack> removed_stracks;
-    std::vector<STrack> lost_stracks;
-    std::vector<STrack> detections;
-    std::vector<STrack> detections_low;
-
-    std::vector<STrack> detections_cp;
-    std::vector<STrack> tracked_stracks_swap;
-    std::vector<STrack> resa, resb;
     std::vector<STrack> output_stracks;
+    output_stracks.reserve(output_ptrs.size());
+    for (int i = 0; i < output_ptrs.size(); i++) {
+        output_stracks.push_back(*output_ptrs[i]);
+    }
+    return output_stracks;
+}
+
+void BYTETracker::update(const std::vector<Object> &objects, std::vector<TrackHandle> &output) {
+    update_tracks(objects);
 
-    std::vector<STrack *> unconfirmed;
-    std::vector<STrack *> tracked_stracks;
-    std::vector<STrack *> strack_pool;
-    std::vector<STrack *> r_tracked_stracks;
-
-    if (objects.size() > 0) {
-        for (int i = 0; i < objects.size(); i++) {
-            std::vector<float> tlbr_;
-            tlbr_.resize(4);
-            tlbr_[0] = objects[i].rect.x;
-            tlbr_[1] = objects[i].rect.y;
-            tlbr_[2] = objects[i].rect.x + objects[i].rect.width;
-            tlbr_[3] = objects[i].rect.y + objects[i].rect.height;
-
-            float score = objects[i].prob;
-
-            /* ---- 选择跟踪类别 ---- */
-            //if (objects[i].label != 0)
-            //{
-            //    objects_filter.push_back(objects[i]);
-            //    continue;
-            //}
-
-            STrack strack(STrack::tlbr_to_tlwh(tlbr_), score, objects[i].label);
-            if (score >= track_thresh) {
-                detections.push_back(strack);
-            } else {
-                detections_low.push_back(strack);
-            }
+    output.clear();
+    for (int i = 0; i < this->tracked_stracks.size(); i++) {
+        int slot = this->tracked_stracks[i];
+        if (track_pool[slot].is_activated) {
+            output.push_back(track_pool.handle(slot));
+        }
+    }
+}
+
+const STrack *BYTETracker::get_track(const TrackHandle &handle) const {
+    return track_pool.get(handle);
+}
+
+void BYTETracker::update(const std::vector<Object> &objects, std::vector<const STrack *> &output) {
+    update_tracks(objects);
+    output.assign(output_ptrs.begin(), output_ptrs.end());
+}
+
+TrackSpan BYTETracker::active_tracks() const {
+    return TrackSpan(output_ptrs.data(), output_ptrs.size());
+}
+
+TrackSpan BYTETracker::update_tracks(const std::vector<Object> &objects) {
+
+    ////////////////// Step 1: Get detections //////////////////
+    this->frame_id++;
+    activated_stracks.clear();
+    refind_stracks.clear();
+    removed_stracks_new.clear();
+    lost_stracks_new.clear();
+    detections.clear();
+    detections_low.clear();
+    detections_cp.clear();
+    unconfirmed.clear();
+    tracked_confirmed.clear();
+    r_tracked_stracks.clear();
+    output_ptrs.clear();
+
+    // 检测框对象只增不减，后续帧直接在原对象上重新初始化
+    detection_pool.grow(objects.size());
+
+    for (int i = 0; i < objects.size(); i++) {
+        float tlbr_[4];
+        tlbr_[0] = objects[i].rect.x;
+        tlbr_[1] = objects[i].rect.y;
+        tlbr_[2] = objects[i].rect.x + objects[i].rect.width;
+        tlbr_[3] = objects[i].rect.y + objects[i].rect.height;
+        float tlwh_[4];
+        STrack::tlbr_to_tlwh(tlbr_, tlwh_);
+
+        float score = objects[i].prob;
+
+        /* ---- 选择跟踪类别 ---- */
+        //if (objects[i].label != 0)
+        //{
+        //    objects_filter.push_back(objects[i]);
+        //    continue;
+        //}
+
+        detection_pool[i].reset(tlwh_, score, objects[i].label);
+        if (score >= track_thresh) {
+            detections.push_back(i);
+        } else {
+            detections_low.push_back(i);
         }
     }
 
     // Add newly detected tracklets to tracked_stracks
     for (int i = 0; i < this->tracked_stracks.size(); i++) {
-        if (!this->tracked_stracks[i].is_activated)
-            unconfirmed.push_back(&this->tracked_stracks[i]);
+        int slot = this->tracked_stracks[i];
+        if (!track_pool[slot].is_activated)
+            unconfirmed.push_back(slot);
         else
-            tracked_stracks.push_back(&this->tracked_stracks[i]);
+            tracked_confirmed.push_back(slot);
     }
 
     ////////////////// Step 2: First association, with IoU //////////////////
-    strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
-    STrack::multi_predict(strack_pool, this->kalman_filter);
-
-    std::vector<std::vector<float> > dists;
-    int dist_size = 0, dist_size_size = 0;
-    dists = iou_distance(strack_pool, detections, dist_size, dist_size_size);
+    joint_stracks(tracked_confirmed, this->lost_stracks, strack_pool);
+    predict_stracks.clear();
+    for (int i = 0; i < strack_pool.size(); i++) {
+        predict_stracks.push_back(&track_pool[strack_pool[i]]);
+    }
+    STrack::multi_predict(predict_stracks, this->batch_kalman);
 
-    std::vector<std::vector<int> > matches;
-    std::vector<int> u_track, u_detection;
-    linear_assignment(dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
+    associate(track_pool, strack_pool, detection_pool, detections, match_thresh, matches, u_track, u_detection);
 
+    update_stracks.clear();
+    update_dets.clear();
     for (int i = 0; i < matches.size(); i++) {
-        STrack *track = strack_pool[matches[i][0]];
-        STrack *det = &detections[matches[i][1]];
+        int slot = strack_pool[matches[i].first];
+        STrack *track = &track_pool[slot];
         if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
+            activated_stracks.push_back(slot);
         } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
+            refind_stracks.push_back(slot);
         }
+        update_stracks.push_back(track);
+        update_dets.push_back(&detection_pool[detections[matches[i].second]]);
     }
+    STrack::multi_update(update_stracks, update_dets, this->frame_id, this->batch_kalman);
 
     ////////////////// Step 3: Second association, using low score dets //////////////////
     for (int i = 0; i < u_detection.size(); i++) {
         detections_cp.push_back(detections[u_detection[i]]);
     }
-    detections.clear();
-    detections.assign(detections_low.begin(), detections_low.end());
 
     for (int i = 0; i < u_track.size(); i++) {
-        if (strack_pool[u_track[i]]->state == TrackState::Tracked) {
+        if (track_pool[strack_pool[u_track[i]]].state == TrackState::Tracked) {
             r_tracked_stracks.push_back(strack_pool[u_track[i]]);
         }
     }
 
-    dists.clear();
-    dists = iou_distance(r_tracked_stracks, detections, dist_size, dist_size_size);
-
-    matches.clear();
-    u_track.clear();
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
+    associate(track_pool, r_tracked_stracks, detection_pool, detections_low, 0.5, matches, u_track, u_detection);
 
+    update_stracks.clear();
+    update_dets.clear();
     for (int i = 0; i < matches.size(); i++) {
-        STrack *track = r_tracked_stracks[matches[i][0]];
-        STrack *det = &detections[matches[i][1]];
+        int slot = r_tracked_stracks[matches[i].first];
+        STrack *track = &track_pool[slot];
         if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
+            activated_stracks.push_back(slot);
         } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
+            refind_stracks.push_back(slot);
         }
+        update_stracks.push_back(track);
+        update_dets.push_back(&detection_pool[detections_low[matches[i].second]]);
     }
+    STrack::multi_update(update_stracks, update_dets, this->frame_id, this->batch_kalman);
 
     for (int i = 0; i < u_track.size(); i++) {
-        STrack *track = r_tracked_stracks[u_track[i]];
+        int slot = r_tracked_stracks[u_track[i]];
+        STrack *track = &track_pool[slot];
         if (track->state != TrackState::Lost) {
             track->mark_lost();
-            lost_stracks.push_back(*track);
+            lost_stracks_new.push_back(slot);
         }
     }
 
     // Deal with unconfirmed tracks, usually tracks with only one beginning frame
-    detections.clear();
-    detections.assign(detections_cp.begin(), detections_cp.end());
-
-    dists.clear();
-    dists = iou_distance(unconfirmed, detections, dist_size, dist_size_size);
-
-    matches.clear();
-    std::vector<int> u_unconfirmed;
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
+    associate(track_pool, unconfirmed, detection_pool, detections_cp, 0.7, matches, u_track, u_detection);
 
+    update_stracks.clear();
+    update_dets.clear();
     for (int i = 0; i < matches.size(); i++) {
-        unconfirmed[matches[i][0]]->update(detections[matches[i][1]], this->frame_id);
-        activated_stracks.push_back(*unconfirmed[matches[i][0]]);
+        int slot = unconfirmed[matches[i].first];
+        update_stracks.push_back(&track_pool[slot]);
+        update_dets.push_back(&detection_pool[detections_cp[matches[i].second]]);
+        activated_stracks.push_back(slot);
     }
+    STrack::multi_update(update_stracks, update_dets, this->frame_id, this->batch_kalman);
 
-    for (int i = 0; i < u_unconfirmed.size(); i++) {
-        STrack *track = unconfirmed[u_unconfirmed[i]];
-        track->mark_removed();
-        removed_stracks.push_back(*track);
+    for (int i = 0; i < u_track.size(); i++) {
+        int slot = unconfirmed[u_track[i]];
+        track_pool[slot].mark_removed();
+        removed_stracks_new.push_back(slot);
     }
 
     ////////////////// Step 4: Init new stracks //////////////////
     for (int i = 0; i < u_detection.size(); i++) {
-        STrack *track = &detections[u_detection[i]];
-        if (track->score < this->high_thresh)
+        const STrack &det = detection_pool[detections_cp[u_detection[i]]];
+        if (det.score < this->high_thresh)
             continue;
-        track->activate(this->kalman_filter, this->frame_id);
-        activated_stracks.push_back(*track);
+        int slot = new_track_slot();
+        track_pool[slot] = det;
+        track_pool[slot].activate(this->kalman_filter, this->frame_id, id_generator());
+        activated_stracks.push_back(slot);
     }
 
     ////////////////// Step 5: Update state //////////////////
     for (int i = 0; i < this->lost_stracks.size(); i++) {
-        if (this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost) {
-            this->lost_stracks[i].mark_removed();
-            removed_stracks.push_back(this->lost_stracks[i]);
+        int slot = this->lost_stracks[i];
+        if (this->frame_id - track_pool[slot].end_frame() > this->max_time_lost) {
+            track_pool[slot].mark_removed();
+            removed_stracks_new.push_back(slot);
         }
     }
 
+    list_swap.clear();
     for (int i = 0; i < this->tracked_stracks.size(); i++) {
-        if (this->tracked_stracks[i].state == TrackState::Tracked) {
-            tracked_stracks_swap.push_back(this->tracked_stracks[i]);
+        if (track_pool[this->tracked_stracks[i]].state == TrackState::Tracked) {
+            list_swap.push_back(this->tracked_stracks[i]);
         }
     }
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(tracked_stracks_swap.begin(), tracked_stracks_swap.end());
 
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, activated_stracks);
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, refind_stracks);
+    joint_stracks(list_swap, activated_stracks, this->tracked_stracks);
+    list_swap.swap(this->tracked_stracks);
+    joint_stracks(list_swap, refind_stracks, this->tracked_stracks);
 
-    //std::cout << activated_stracks.size() << std::endl;
+    sub_stracks(this->lost_stracks, this->tracked_stracks, list_swap);
+    list_swap.insert(list_swap.end(), lost_stracks_new.begin(), lost_stracks_new.end());
 
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->tracked_stracks);
-    for (int i = 0; i < lost_stracks.size(); i++) {
-        this->lost_stracks.push_back(lost_stracks[i]);
-    }
+    sub_stracks(list_swap, this->removed_stracks, this->lost_stracks);
+    this->removed_stracks.swap(removed_stracks_new);
 
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->removed_stracks);
-    this->removed_stracks.clear();
-    for (int i = 0; i < removed_stracks.size(); i++) {
-        this->removed_stracks.push_back(removed_stracks[i]);
+    list_swap.swap(this->tracked_stracks);
+    remove_duplicate_stracks(this->tracked_stracks, lost_stracks_new, list_swap, this->lost_stracks);
+    this->lost_stracks.swap(lost_stracks_new);
+
+    recycle_track_slots();
+
+    for (int i = 0; i < this->tracked_stracks.size(); i++) {
+        const STrack &track = track_pool[this->tracked_stracks[i]];
+        if (track.is_activated) {
+            output_ptrs.push_back(&track);
+        }
     }
+    return active_tracks();
+}
 
-    remove_duplicate_stracks(resa, resb, this->tracked_stracks, this->lost_stracks);
+void BYTETracker::set_num_threads(int num_threads) {
+    this->num_threads = num_threads;
+}
 
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(resa.begin(), resa.end());
-    this->lost_stracks.clear();
-    this->lost_stracks.assign(resb.begin(), resb.end());
+void BYTETracker::set_dense_max_pairs(long long max_pairs) {
+    dense_max_pairs = max_pairs;
+}
 
+void BYTETracker::set_track_ids(int first, int step) {
+    track_ids.reset(first, step);
+}
+
+void BYTETracker::set_id_generator(TrackIdGenerator *track_ids) {
+    shared_track_ids = track_ids;
+}
+
+TrackIdGenerator &BYTETracker::id_generator() {
+    return shared_track_ids ? *shared_track_ids : track_ids;
+}
+
+int BYTETracker::new_track_slot() {
+    int slot = track_pool.allocate();
+    if ((int) slot_marks.size() < track_pool.size()) {
+        slot_marks.resize(track_pool.size(), 0);
+    }
+    return slot;
+}
+
+void BYTETracker::recycle_track_slots() {
+    // 不在任何列表中的轨迹槽位回收，removed_stracks要保留到下一帧用于sub_stracks
     for (int i = 0; i < this->tracked_stracks.size(); i++) {
-        if (this->tracked_stracks[i].is_activated) {
-            output_stracks.push_back(this->tracked_stracks[i]);
+        slot_marks[this->tracked_stracks[i]] = this->frame_id;
+    }
+    for (int i = 0; i < this->lost_stracks.size(); i++) {
+        slot_marks[this->lost_stracks[i]] = this->frame_id;
+    }
+    for (int i = 0; i < this->removed_stracks.size(); i++) {
+        slot_marks[this->removed_stracks[i]] = this->frame_id;
+    }
+
+    for (int slot = 0; slot < track_pool.size(); slot++) {
+        if (track_pool.in_use(slot) && slot_marks[slot] != this->frame_id) {
+            track_pool.release(slot);
         }
     }
-    return output_stracks;
-}
\ No newline at end of file
+}
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "STrack.h"
+#include "trackPool.h"
+#include "lapSolver.h"
+#include "sparseAssociation.h"
+#include "iouKernel.h"
+#include "trackIdSet.h"
 #include "../common.h"
 
 //struct YoloObject {
@@ -9,6 +14,49 @@
 //		float prob;
 //};
 
+/**
+ * 已激活轨迹的只读视图，直接指向跟踪器内部的对象，不拷贝轨迹，下一次update之前有效
+ */
+class TrackSpan {
+public:
+    class iterator {
+    public:
+        explicit iterator(const STrack *const *p) : p_(p) {}
+
+        const STrack &operator*() const { return **p_; }
+
+        const STrack *operator->() const { return *p_; }
+
+        iterator &operator++() {
+            ++p_;
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return p_ == other.p_; }
+
+        bool operator!=(const iterator &other) const { return p_ != other.p_; }
+
+    private:
+        const STrack *const *p_;
+    };
+
+    TrackSpan(const STrack *const *data, size_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    const STrack &operator[](size_t i) const { return *data_[i]; }
+
+    iterator begin() const { return iterator(data_); }
+
+    iterator end() const { return iterator(data_ + size_); }
+
+private:
+    const STrack *const *data_;
+    size_t size_;
+};
+
 class BYTETracker {
 public:
     BYTETracker(int frame_rate = 15, int track_buffer = 60);
@@ -17,34 +65,98 @@ public:
 
     std::vector<STrack> update(const std::vector<Object> &objects);
 
+    /**
+     * 不拷贝轨迹的update，稳定运行后不再分配内存
+     * @param objects 当前帧的检测结果
+     * @param output 已激活的轨迹，指向跟踪器内部的对象，下一次update之前有效
+     */
+    void update(const std::vector<Object> &objects, std::vector<const STrack *> &output);
+
+    /**
+     * 输出已激活轨迹的句柄，句柄在轨迹被回收之前一直有效，可以跨帧保存，用get_track取轨迹
+     */
+    void update(const std::vector<Object> &objects, std::vector<TrackHandle> &output);
+
+    /**
+     * 不拷贝轨迹的update，返回已激活轨迹的只读视图，视图在下一次update之前有效
+     */
+    TrackSpan update_tracks(const std::vector<Object> &objects);
+
+    // 最近一次update之后已激活的轨迹
+    TrackSpan active_tracks() const;
+
+    // 对最近一次update之后的每条已激活轨迹调用visit(const STrack &)
+    template<typename Visitor>
+    void visit_active_tracks(Visitor visit) const {
+        for (size_t i = 0; i < output_ptrs.size(); i++) {
+            visit(*output_ptrs[i]);
+        }
+    }
+
+    // 句柄对应的轨迹已被回收时返回nullptr
+    const STrack *get_track(const TrackHandle &handle) const;
+
     cv::Scalar get_color(int idx);
 
+    /**
+     * 大规模关联时按连通分量并行求解的线程数，默认1
+     */
+    void set_num_threads(int num_threads);
+
+    /**
+     * 轨迹数 x 检测数 超过max_pairs时IoU关联改用稀疏的分量分解，默认64 * 64，0表示总是使用稀疏关联
+     */
+    void set_dense_max_pairs(long long max_pairs);
+
+    /**
+     * 新轨迹id从first开始，每次增加step，默认每个跟踪器从1开始独立计数。
+     * K路视频需要互不相同的id时，第k路设为 (k + 1, K)
+     */
+    void set_track_ids(int first, int step = 1);
+
+    /**
+     * 使用外部的id生成器，多个跟踪器共用一个生成器时id全局唯一，nullptr恢复使用跟踪器自己的生成器。
+     * 生成器的生命周期由调用方保证
+     */
+    void set_id_generator(TrackIdGenerator *track_ids);
+
 private:
-    std::vector<STrack *> joint_stracks(std::vector<STrack *> &tlista, std::vector<STrack> &tlistb);
+    // 轨迹列表中保存的是track_pool中的下标，同一条轨迹在多个列表之间传递时不拷贝STrack
+    typedef std::vector<int> TrackList;
+
+    int new_track_slot();
+
+    TrackIdGenerator &id_generator();
 
-    std::vector<STrack> joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
+    void recycle_track_slots();
 
-    std::vector<STrack> sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
+    void joint_stracks(const TrackList &tlista, const TrackList &tlistb, TrackList &res);
 
-    void remove_duplicate_stracks(std::vector<STrack> &resa, std::vector<STrack> &resb, std::vector<STrack> &stracksa,
-                                  std::vector<STrack> &stracksb);
+    void sub_stracks(const TrackList &tlista, const TrackList &tlistb, TrackList &res);
 
-    void
-    linear_assignment(std::vector<std::vector<float> > &cost_matrix, int cost_matrix_size, int cost_matrix_size_size,
-                      float thresh,
-                      std::vector<std::vector<int> > &matches, std::vector<int> &unmatched_a,
-                      std::vector<int> &unmatched_b);
+    void remove_duplicate_stracks(TrackList &resa, TrackList &resb, const TrackList &stracksa,
+                                  const TrackList &stracksb);
 
-    std::vector<std::vector<float> >
-    iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks, int &dist_size, int &dist_size_size);
+    /**
+     * IoU关联，规模小时用稠密矩阵，轨迹数 x 检测数 超过dense_max_pairs时改用稀疏的分量分解。
+     * 两者的最优总代价相同，最优解唯一时匹配也相同；存在代价相等的多个最优解时可能选中不同的一个
+     */
+    void associate(const STrackPool &apool, const TrackList &atracks,
+                   const STrackPool &bpool, const TrackList &btracks, float thresh,
+                   std::vector<std::pair<int, int> > &matches, std::vector<int> &unmatched_a,
+                   std::vector<int> &unmatched_b);
 
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks);
+    void gather_tlbrs(const STrackPool &pool, const TrackList &tracks, std::vector<float> &tlbrs);
 
-    std::vector<std::vector<float> >
-    ious(std::vector<std::vector<float> > &atlbrs, std::vector<std::vector<float> > &btlbrs);
+    void linear_assignment(const std::vector<float> &cost_matrix, int cost_matrix_size, int cost_matrix_size_size,
+                           float thresh,
+                           std::vector<std::pair<int, int> > &matches, std::vector<int> &unmatched_a,
+                           std::vector<int> &unmatched_b);
 
-    double lapjv(const std::vector<std::vector<float> > &cost, std::vector<int> &rowsol, std::vector<int> &colsol,
-                 bool extend_cost = false, float cost_limit = LONG_MAX, bool return_cost = true);
+    // 代价矩阵按行优先写入cost_matrix，行对应atracks，列对应btracks
+    void iou_distance(const STrackPool &apool, const TrackList &atracks,
+                      const STrackPool &bpool, const TrackList &btracks,
+                      std::vector<float> &cost_matrix);
 
 private:
 
@@ -53,9 +165,60 @@ private:
     float match_thresh;
     int frame_id;
     int max_time_lost;
+    int num_threads;
+    long long dense_max_pairs;
 
-    std::vector<STrack> tracked_stracks;
-    std::vector<STrack> lost_stracks;
-    std::vector<STrack> removed_stracks;
+    TrackList tracked_stracks;
+    TrackList lost_stracks;
+    TrackList removed_stracks;
     byte_kalman::KalmanFilter kalman_filter;
-};
\ No newline at end of file
+    // 新轨迹的id，shared_track_ids非空时使用外部生成器
+    TrackIdGenerator track_ids;
+    TrackIdGenerator *shared_track_ids;
+    // 预测和更新时所有轨迹的SoA卡尔曼状态
+    byte_kalman::BatchKalmanFilter batch_kalman;
+
+    // 轨迹和检测框的存储，对象地址不随扩容改变；轨迹槽位在不属于任何列表后回收复用，检测框按下标复用
+    STrackPool track_pool;
+    std::vector<int> slot_marks;
+    STrackPool detection_pool;
+
+    // 以下为update中使用的临时缓冲区，每帧clear后复用
+    TrackList detections;
+    TrackList detections_low;
+    TrackList detections_cp;
+    TrackList activated_stracks;
+    TrackList refind_stracks;
+    TrackList lost_stracks_new;
+    TrackList removed_stracks_new;
+    TrackList unconfirmed;
+    TrackList tracked_confirmed;
+    TrackList strack_pool;
+    TrackList r_tracked_stracks;
+    TrackList list_swap;
+    TrackList dupa;
+    TrackList dupb;
+    std::vector<STrack *> predict_stracks;
+    std::vector<STrack *> update_stracks;
+    std::vector<const STrack *> update_dets;
+    std::vector<float> dists;
+    TlbrBoxes aboxes;
+    TlbrBoxes bboxes;
+    std::vector<std::pair<int, int> > matches;
+    std::vector<int> u_track;
+    std::vector<int> u_detection;
+    std::vector<int> rowsol;
+    std::vector<int> colsol;
+    // 最近一次update之后已激活的轨迹
+    std::vector<const STrack *> output_ptrs;
+
+    // 指派问题求解器，工作区跨帧复用
+    LapSolver lap_solver;
+    SparseAssociation sparse_association;
+    std::vector<float> atlbrs;
+    std::vector<float> btlbrs;
+    std::vector<std::pair<int, int> > dup_pairs;
+    // 轨迹列表合并、求差时按track_id去重
+    TrackIdSet id_set;
+    std::vector<std::pair<int, int> > id_slots;
+};
@@ -0,0 +1,27 @@
+#include "BYTETrackerGroup.h"
+#include <cstdio>
+
+BYTETrackerGroup::BYTETrackerGroup(int num_trackers, int frame_rate, int track_buffer, int num_threads,
+                                   TrackIdMode id_mode)
+        : pool(num_threads) {
+    trackers.reserve(num_trackers);
+    for (int k = 0; k < num_trackers; k++) {
+        trackers.emplace_back(new BYTETracker(frame_rate, track_buffer));
+        if (id_mode == TrackIdMode::GroupUnique) {
+            trackers[k]->set_track_ids(k + 1, num_trackers);
+        }
+    }
+}
+
+int BYTETrackerGroup::update(const std::vector<std::vector<Object> > &objects,
+                             std::vector<std::vector<const STrack *> > &outputs) {
+    if (objects.size() != trackers.size()) {
+        fprintf(stderr, "tracker group: %d inputs for %d trackers\n", (int) objects.size(), size());
+        return -1;
+    }
+    outputs.resize(trackers.size());
+    pool.parallel_for(size(), [&](int k) {
+        trackers[k]->update(objects[k], outputs[k]);
+    });
+    return 0;
+}
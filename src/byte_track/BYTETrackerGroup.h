@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include "BYTETracker.h"
+#include "../work_stealing_pool.h"
+
+// 跟踪器组中轨迹id的分配方式
+enum class TrackIdMode {
+    PerTracker = 0, // 每路从1开始独立计数，id只在本路内唯一
+    GroupUnique     // 第k路的id为 k + 1 + n * K，整个组内唯一
+};
+
+/**
+ * K个相互独立的BYTETracker，每路视频一个，update在工作窃取线程池上并行更新所有跟踪器。
+ * 每个跟踪器使用自己的id生成器，结果与串行逐路更新完全一致，不受线程数和调度顺序影响
+ */
+class BYTETrackerGroup {
+public:
+    /**
+     * @param num_trackers 跟踪器个数
+     * @param num_threads 线程数（包含调用线程），<=0时使用硬件线程数
+     */
+    BYTETrackerGroup(int num_trackers, int frame_rate = 15, int track_buffer = 60, int num_threads = 0,
+                     TrackIdMode id_mode = TrackIdMode::PerTracker);
+
+    int size() const { return (int) trackers.size(); }
+
+    BYTETracker &tracker(int i) { return *trackers[i]; }
+
+    /**
+     * 并行更新所有跟踪器
+     * @param objects 每路当前帧的检测结果，大小必须等于size()
+     * @param outputs 每路已激活的轨迹，指向跟踪器内部的对象，下一次update之前有效
+     * @return 0成功，输入路数不对时返回-1
+     */
+    int update(const std::vector<std::vector<Object> > &objects,
+               std::vector<std::vector<const STrack *> > &outputs);
+
+private:
+    // BYTETracker内部缓冲区较多，各自单独分配，避免相邻跟踪器的状态共享cache line
+    std::vector<std::unique_ptr<BYTETracker> > trackers;
+    WorkStealingPool pool;
+};
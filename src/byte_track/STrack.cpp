@@ -1,16 +1,23 @@
 #include "STrack.h"
 
-STrack::STrack(std::vector<float> tlwh_, float score, int class_id) {
-    _tlwh.resize(4);
-    _tlwh.assign(tlwh_.begin(), tlwh_.end());
+STrack::STrack() {
+    const float zeros[4] = {0.f, 0.f, 0.f, 0.f};
+    reset(zeros, 0.f, 0);
+}
+
+STrack::STrack(const float *tlwh_, float score, int class_id) {
+    reset(tlwh_, score, class_id);
+}
+
+void STrack::reset(const float *tlwh_, float score, int class_id) {
+    for (int i = 0; i < 4; i++) {
+        _tlwh[i] = tlwh_[i];
+    }
 
     is_activated = false;
     track_id = 0;
     state = TrackState::New;
 
-    tlwh.resize(4);
-    tlbr.resize(4);
-
     static_tlwh();
     static_tlbr();
     frame_id = 0;
@@ -20,25 +27,15 @@ STrack::STrack(std::vector<float> tlwh_, float score, int class_id) {
     start_frame = 0;
 }
 
-STrack::~STrack() {
+void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id) {
+    activate(kalman_filter, frame_id, TrackIdGenerator::global());
 }
 
-void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id) {
-    this->kalman_filter = kalman_filter;
-    this->track_id = this->next_id();
-
-    std::vector<float> _tlwh_tmp(4);
-    _tlwh_tmp[0] = this->_tlwh[0];
-    _tlwh_tmp[1] = this->_tlwh[1];
-    _tlwh_tmp[2] = this->_tlwh[2];
-    _tlwh_tmp[3] = this->_tlwh[3];
-    std::vector<float> xyah = tlwh_to_xyah(_tlwh_tmp);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
-    auto mc = this->kalman_filter.initiate(xyah_box);
+void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id, TrackIdGenerator &track_ids) {
+    this->track_id = track_ids.next();
+
+    DETECTBOX xyah_box = tlwh_to_xyah_box(this->_tlwh);
+    auto mc = kalman_filter.initiate(xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
@@ -55,17 +52,16 @@ void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id) {
     this->start_frame = frame_id;
 }
 
-void STrack::re_activate(STrack &new_track, int frame_id, bool new_id) {
-    std::vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
-    auto mc = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
+void STrack::re_activate(const STrack &new_track, int frame_id, bool new_id) {
+    DETECTBOX xyah_box = tlwh_to_xyah_box(new_track.tlwh);
+    auto mc = shared_kalman().update(this->mean, this->covariance, xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
+    re_activated(new_track, frame_id, new_id);
+}
+
+void STrack::re_activated(const STrack &new_track, int frame_id, bool new_id) {
     static_tlwh();
     static_tlbr();
 
@@ -78,21 +74,20 @@ void STrack::re_activate(STrack &new_track, int frame_id, bool new_id) {
         this->track_id = next_id();
 }
 
-void STrack::update(STrack &new_track, int frame_id) {
-    this->frame_id = frame_id;
-    this->tracklet_len++;
-
-    std::vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
+void STrack::update(const STrack &new_track, int frame_id) {
+    DETECTBOX xyah_box = tlwh_to_xyah_box(new_track.tlwh);
 
-    auto mc = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
+    auto mc = shared_kalman().update(this->mean, this->covariance, xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
+    updated(new_track, frame_id);
+}
+
+void STrack::updated(const STrack &new_track, int frame_id) {
+    this->frame_id = frame_id;
+    this->tracklet_len++;
+
     static_tlwh();
     static_tlbr();
 
@@ -122,28 +117,37 @@ void STrack::static_tlwh() {
 }
 
 void STrack::static_tlbr() {
-    tlbr.clear();
-    tlbr.assign(tlwh.begin(), tlwh.end());
-    tlbr[2] += tlbr[0];
-    tlbr[3] += tlbr[1];
+    tlbr[0] = tlwh[0];
+    tlbr[1] = tlwh[1];
+    tlbr[2] = tlwh[2] + tlwh[0];
+    tlbr[3] = tlwh[3] + tlwh[1];
 }
 
-std::vector<float> STrack::tlwh_to_xyah(std::vector<float> tlwh_tmp) {
-    std::vector<float> tlwh_output = tlwh_tmp;
-    tlwh_output[0] += tlwh_output[2] / 2;
-    tlwh_output[1] += tlwh_output[3] / 2;
-    tlwh_output[2] /= tlwh_output[3];
-    return tlwh_output;
+void STrack::tlwh_to_xyah(const float *tlwh_tmp, float *xyah) {
+    xyah[0] = tlwh_tmp[0] + tlwh_tmp[2] / 2;
+    xyah[1] = tlwh_tmp[1] + tlwh_tmp[3] / 2;
+    xyah[2] = tlwh_tmp[2] / tlwh_tmp[3];
+    xyah[3] = tlwh_tmp[3];
 }
 
-std::vector<float> STrack::to_xyah() {
-    return tlwh_to_xyah(tlwh);
+DETECTBOX STrack::tlwh_to_xyah_box(const float *tlwh_tmp) {
+    DETECTBOX xyah_box;
+    xyah_box[0] = tlwh_tmp[0] + tlwh_tmp[2] / 2;
+    xyah_box[1] = tlwh_tmp[1] + tlwh_tmp[3] / 2;
+    xyah_box[2] = tlwh_tmp[2] / tlwh_tmp[3];
+    xyah_box[3] = tlwh_tmp[3];
+    return xyah_box;
 }
 
-std::vector<float> STrack::tlbr_to_tlwh(std::vector<float> &tlbr) {
-    tlbr[2] -= tlbr[0];
-    tlbr[3] -= tlbr[1];
-    return tlbr;
+void STrack::to_xyah(float *xyah) const {
+    tlwh_to_xyah(tlwh, xyah);
+}
+
+void STrack::tlbr_to_tlwh(const float *tlbr, float *tlwh) {
+    tlwh[0] = tlbr[0];
+    tlwh[1] = tlbr[1];
+    tlwh[2] = tlbr[2] - tlbr[0];
+    tlwh[3] = tlbr[3] - tlbr[1];
 }
 
 void STrack::mark_lost() {
@@ -155,22 +159,54 @@ void STrack::mark_removed() {
 }
 
 int STrack::next_id() {
-    static int _count = 0;
-    _count++;
-    return _count;
+    return TrackIdGenerator::global().next();
 }
 
-int STrack::end_frame() {
+int STrack::end_frame() const {
     return this->frame_id;
 }
 
-void STrack::multi_predict(std::vector<STrack *> &stracks, byte_kalman::KalmanFilter &kalman_filter) {
+byte_kalman::KalmanFilter &STrack::shared_kalman() {
+    static byte_kalman::KalmanFilter kalman_filter;
+    return kalman_filter;
+}
+
+void STrack::multi_predict(std::vector<STrack *> &stracks, byte_kalman::BatchKalmanFilter &batch_kalman) {
+    batch_kalman.resize(stracks.size());
     for (int i = 0; i < stracks.size(); i++) {
         if (stracks[i]->state != TrackState::Tracked) {
             stracks[i]->mean[7] = 0;
         }
-        kalman_filter.predict(stracks[i]->mean, stracks[i]->covariance);
+        batch_kalman.set(i, stracks[i]->mean, stracks[i]->covariance);
+    }
+
+    batch_kalman.predict();
+
+    for (int i = 0; i < stracks.size(); i++) {
+        batch_kalman.get(i, stracks[i]->mean, stracks[i]->covariance);
         stracks[i]->static_tlwh();
         stracks[i]->static_tlbr();
     }
-}
\ No newline at end of file
+}
+
+void STrack::multi_update(std::vector<STrack *> &stracks, const std::vector<const STrack *> &new_tracks,
+                          int frame_id, byte_kalman::BatchKalmanFilter &batch_kalman) {
+    batch_kalman.resize(stracks.size());
+    for (int i = 0; i < stracks.size(); i++) {
+        float xyah[4];
+        tlwh_to_xyah(new_tracks[i]->tlwh, xyah);
+        batch_kalman.set(i, stracks[i]->mean, stracks[i]->covariance);
+        batch_kalman.set_measurement(i, xyah);
+    }
+
+    batch_kalman.update();
+
+    for (int i = 0; i < stracks.size(); i++) {
+        batch_kalman.get(i, stracks[i]->mean, stracks[i]->covariance);
+        if (stracks[i]->state == TrackState::Tracked) {
+            stracks[i]->updated(*new_tracks[i], frame_id);
+        } else {
+            stracks[i]->re_activated(*new_tracks[i], frame_id, false);
+        }
+    }
+}
@@ -2,60 +2,89 @@
 
 #include <opencv2/opencv.hpp>
 #include "kalmanFilter.h"
+#include "batchKalmanFilter.h"
+#include "trackIdGenerator.h"
 
 enum TrackState {
     New = 0, Tracked, Lost, Removed
 };
 
-class STrack {
+/**
+ * 轨迹记录，框坐标为定长数组，拷贝不分配内存
+ * 关联阶段频繁访问的字段放在第一个cache line，卡尔曼状态放在后面
+ */
+class alignas(64) STrack {
 public:
-    STrack(std::vector<float> tlwh_, float score, int class_id);
+    STrack();
 
-    ~STrack();
+    STrack(const float *tlwh_, float score, int class_id);
 
-    std::vector<float> static tlbr_to_tlwh(std::vector<float> &tlbr);
+    // 复用已有对象重新初始化为一个检测框
+    void reset(const float *tlwh_, float score, int class_id);
 
-    void static multi_predict(std::vector<STrack *> &stracks, byte_kalman::KalmanFilter &kalman_filter);
+    void static tlbr_to_tlwh(const float *tlbr, float *tlwh);
+
+    // 所有轨迹放在一个批次里预测
+    void static multi_predict(std::vector<STrack *> &stracks, byte_kalman::BatchKalmanFilter &batch_kalman);
+
+    /**
+     * 批量用匹配的检测框更新轨迹，Tracked状态的轨迹按update处理，其余按re_activate处理（不换id）
+     */
+    void static multi_update(std::vector<STrack *> &stracks, const std::vector<const STrack *> &new_tracks,
+                             int frame_id, byte_kalman::BatchKalmanFilter &batch_kalman);
 
     void static_tlwh();
 
     void static_tlbr();
 
-    std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp);
+    void static tlwh_to_xyah(const float *tlwh_tmp, float *xyah);
 
-    std::vector<float> to_xyah();
+    void to_xyah(float *xyah) const;
 
     void mark_lost();
 
     void mark_removed();
 
+    // 从进程内共用的生成器取id，线程安全
     int next_id();
 
-    int end_frame();
+    int end_frame() const;
 
     void activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id);
 
-    void re_activate(STrack &new_track, int frame_id, bool new_id = false);
+    // 从指定的生成器取新轨迹的id
+    void activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id, TrackIdGenerator &track_ids);
 
-    void update(STrack &new_track, int frame_id);
+    void re_activate(const STrack &new_track, int frame_id, bool new_id = false);
+
+    void update(const STrack &new_track, int frame_id);
 
 public:
-    bool is_activated;
+    // cache line 0：iou、状态判断和输出用到的字段
+    float tlbr[4];
+    float tlwh[4];
     int track_id;
     int state;
-
-    std::vector<float> _tlwh;
-    std::vector<float> tlwh;
-    std::vector<float> tlbr;
     int frame_id;
-    int tracklet_len;
     int start_frame;
+    int tracklet_len;
+    float score;
+    int class_id;
+    bool is_activated;
 
+    // 卡尔曼状态
+    float _tlwh[4];
     KAL_MEAN mean;
     KAL_COVA covariance;
-    float score;
-    int class_id;
 
 private:
-    byte_kalman::KalmanFilter kalman_filter;
-};
\ No newline at end of file
+    // update和re_activate中卡尔曼更新之后的状态修改
+    void updated(const STrack &new_track, int frame_id);
+
+    void re_activated(const STrack &new_track, int frame_id, bool new_id);
+
+    static DETECTBOX tlwh_to_xyah_box(const float *tlwh_tmp);
+
+    // 卡尔曼滤波器只有常量矩阵，所有轨迹共用一个
+    static byte_kalman::KalmanFilter &shared_kalman();
+};
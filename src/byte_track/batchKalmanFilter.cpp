@@ -0,0 +1,293 @@
+#include "batchKalmanFilter.h"
+
+// x86-64都有SSE2；aarch64的NEON才有除法
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KALMAN_SSE2 1
+#define KALMAN_SIMD 1
+#elif __ARM_NEON && __aarch64__
+#include <arm_neon.h>
+#define KALMAN_SIMD 1
+#endif
+
+namespace byte_kalman {
+    // 4x4对称矩阵上三角的压缩下标
+    static const int sym4_index[4][4] = {
+            {0, 1, 2, 3},
+            {1, 4, 5, 6},
+            {2, 5, 7, 8},
+            {3, 6, 8, 9}
+    };
+
+    // 8x8协方差在压缩数组中的下标：A为0..9，B按行为10..25，C为26..35
+    static const int cova_index[8][8] = {
+            {0,  1,  2,  3,  10, 11, 12, 13},
+            {1,  4,  5,  6,  14, 15, 16, 17},
+            {2,  5,  7,  8,  18, 19, 20, 21},
+            {3,  6,  8,  9,  22, 23, 24, 25},
+            {10, 14, 18, 22, 26, 27, 28, 29},
+            {11, 15, 19, 23, 27, 30, 31, 32},
+            {12, 16, 20, 24, 28, 31, 33, 34},
+            {13, 17, 21, 25, 29, 32, 34, 35}
+    };
+
+    // 一条轨迹
+    struct Lane1 {
+        float v;
+
+        static Lane1 load(const float *p) { return {*p}; }
+
+        static Lane1 set1(float x) { return {x}; }
+
+        void store(float *p) const { *p = v; }
+    };
+
+    static inline Lane1 operator+(Lane1 a, Lane1 b) { return {a.v + b.v}; }
+
+    static inline Lane1 operator-(Lane1 a, Lane1 b) { return {a.v - b.v}; }
+
+    static inline Lane1 operator*(Lane1 a, Lane1 b) { return {a.v * b.v}; }
+
+    static inline Lane1 operator/(Lane1 a, Lane1 b) { return {a.v / b.v}; }
+
+    static inline Lane1 operator-(Lane1 a) { return {-a.v}; }
+
+#if KALMAN_SIMD
+    // 4条轨迹，只用加减乘除，与Lane1的结果逐位一致
+    struct Lanes4 {
+#if KALMAN_SSE2
+        __m128 v;
+
+        static Lanes4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+
+        static Lanes4 set1(float x) { return {_mm_set1_ps(x)}; }
+
+        void store(float *p) const { _mm_storeu_ps(p, v); }
+#else
+        float32x4_t v;
+
+        static Lanes4 load(const float *p) { return {vld1q_f32(p)}; }
+
+        static Lanes4 set1(float x) { return {vdupq_n_f32(x)}; }
+
+        void store(float *p) const { vst1q_f32(p, v); }
+#endif
+    };
+
+#if KALMAN_SSE2
+    static inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return {_mm_add_ps(a.v, b.v)}; }
+
+    static inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+
+    static inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+
+    static inline Lanes4 operator/(Lanes4 a, Lanes4 b) { return {_mm_div_ps(a.v, b.v)}; }
+
+    static inline Lanes4 operator-(Lanes4 a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.f))}; }
+#else
+    static inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return {vaddq_f32(a.v, b.v)}; }
+
+    static inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return {vsubq_f32(a.v, b.v)}; }
+
+    static inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return {vmulq_f32(a.v, b.v)}; }
+
+    static inline Lanes4 operator/(Lanes4 a, Lanes4 b) { return {vdivq_f32(a.v, b.v)}; }
+
+    static inline Lanes4 operator-(Lanes4 a) { return {vnegq_f32(a.v)}; }
+#endif
+#endif // KALMAN_SIMD
+
+    BatchKalmanFilter::BatchKalmanFilter() {
+        n_ = 0;
+        std_weight_position_ = 1. / 20;
+        std_weight_velocity_ = 1. / 160;
+    }
+
+    void BatchKalmanFilter::resize(int n) {
+        n_ = n;
+        mean_.resize(mean_dim * n);
+        cova_.resize(cova_dim * n);
+        measurement_.resize(measure_dim * n);
+    }
+
+    void BatchKalmanFilter::set(int i, const KAL_MEAN &mean, const KAL_COVA &covariance) {
+        for (int k = 0; k < mean_dim; k++) {
+            mean_[k * n_ + i] = mean(k);
+        }
+        pack_covariance(covariance, &cova_[i], n_);
+    }
+
+    void BatchKalmanFilter::get(int i, KAL_MEAN &mean, KAL_COVA &covariance) const {
+        for (int k = 0; k < mean_dim; k++) {
+            mean(k) = mean_[k * n_ + i];
+        }
+        unpack_covariance(&cova_[i], n_, covariance);
+    }
+
+    void BatchKalmanFilter::set_measurement(int i, const float *xyah) {
+        for (int k = 0; k < measure_dim; k++) {
+            measurement_[k * n_ + i] = xyah[k];
+        }
+    }
+
+    void BatchKalmanFilter::predict() {
+        predict(mean_.data(), cova_.data(), n_, n_, std_weight_position_, std_weight_velocity_);
+    }
+
+    void BatchKalmanFilter::update() {
+        update(mean_.data(), cova_.data(), measurement_.data(), n_, n_, std_weight_position_);
+    }
+
+    void BatchKalmanFilter::pack_covariance(const KAL_COVA &covariance, float *cova, int stride) {
+        for (int r = 0; r < mean_dim; r++) {
+            for (int c = r; c < mean_dim; c++) {
+                cova[cova_index[r][c] * stride] = covariance(r, c);
+            }
+        }
+    }
+
+    void BatchKalmanFilter::unpack_covariance(const float *cova, int stride, KAL_COVA &covariance) {
+        for (int r = 0; r < mean_dim; r++) {
+            for (int c = 0; c < mean_dim; c++) {
+                covariance(r, c) = cova[cova_index[r][c] * stride];
+            }
+        }
+    }
+
+    /**
+     * 预测，V为一条轨迹的float或者4条轨迹打包的simd类型，每个分量从 p[k * stride] 读取
+     */
+    template<typename V>
+    static inline void predict_lanes(float *mean, float *cova, int stride,
+                                     float std_weight_position, float std_weight_velocity) {
+        // 过程噪声按预测前的高度计算，宽高比的噪声是常数
+        const V height = V::load(mean + 3 * stride);
+        const V std_pos = V::set1(std_weight_position) * height;
+        const V std_vel = V::set1(std_weight_velocity) * height;
+        const V var_pos[4] = {std_pos * std_pos, std_pos * std_pos, V::set1(1e-2f * 1e-2f), std_pos * std_pos};
+        const V var_vel[4] = {std_vel * std_vel, std_vel * std_vel, V::set1(1e-5f * 1e-5f), std_vel * std_vel};
+
+        for (int k = 0; k < 4; k++) {
+            (V::load(mean + k * stride) + V::load(mean + (k + 4) * stride)).store(mean + k * stride);
+        }
+
+        V p[BatchKalmanFilter::cova_dim];
+        for (int k = 0; k < BatchKalmanFilter::cova_dim; k++) {
+            p[k] = V::load(cova + k * stride);
+        }
+
+        // A' = (A + B^T) + (B + C)，加法顺序与 F * P * F^T 展开后一致；B' = B + C；C不变
+        for (int r = 0; r < 4; r++) {
+            for (int c = r; c < 4; c++) {
+                V a = (p[cova_index[r][c]] + p[cova_index[c][r + 4]]) + (p[cova_index[r][c + 4]] + p[cova_index[r + 4][c + 4]]);
+                V v = p[cova_index[r + 4][c + 4]];
+                if (r == c) {
+                    a = a + var_pos[r];
+                    v = v + var_vel[r];
+                }
+                a.store(cova + cova_index[r][c] * stride);
+                v.store(cova + cova_index[r + 4][c + 4] * stride);
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                (p[cova_index[r][c + 4]] + p[cova_index[r + 4][c + 4]]).store(cova + cova_index[r][c + 4] * stride);
+            }
+        }
+    }
+
+    /**
+     * 更新，V的含义与predict_lanes相同
+     */
+    template<typename V>
+    static inline void update_lanes(float *mean, float *cova, const float *measurement, int stride,
+                                    float std_weight_position) {
+        V p[BatchKalmanFilter::cova_dim];
+        for (int k = 0; k < BatchKalmanFilter::cova_dim; k++) {
+            p[k] = V::load(cova + k * stride);
+        }
+
+        // 观测噪声R为对角阵，新息协方差 S = A + R，G = S^-1
+        const V std_pos = V::set1(std_weight_position) * V::load(mean + 3 * stride);
+        const V r_diag[4] = {std_pos * std_pos, std_pos * std_pos, V::set1(1e-1f * 1e-1f), std_pos * std_pos};
+        V s[10];
+        for (int r = 0; r < 4; r++) {
+            for (int c = r; c < 4; c++) {
+                s[sym4_index[r][c]] = r == c ? p[cova_index[r][c]] + r_diag[r] : p[cova_index[r][c]];
+            }
+        }
+        V g[10];
+        spd4_inverse(s, g);
+
+        // 新息 y = z - H * x，gy = G * y
+        V y[4];
+        for (int k = 0; k < 4; k++) {
+            y[k] = V::load(measurement + k * stride) - V::load(mean + k * stride);
+        }
+        V gy[4];
+        for (int r = 0; r < 4; r++) {
+            gy[r] = g[sym4_index[r][0]] * y[0] + g[sym4_index[r][1]] * y[1] +
+                    g[sym4_index[r][2]] * y[2] + g[sym4_index[r][3]] * y[3];
+        }
+
+        // 卡尔曼增益 K = [A; B^T] * G，x' = x + K * y
+        for (int j = 0; j < 8; j++) {
+            V x = V::load(mean + j * stride);
+            x = x + (p[cova_index[0][j]] * gy[0] + p[cova_index[1][j]] * gy[1] +
+                     p[cova_index[2][j]] * gy[2] + p[cova_index[3][j]] * gy[3]);
+            x.store(mean + j * stride);
+        }
+
+        // P' = P - K * [A B]，代入 A = S - R 化简：
+        // A' = A * G * R，B' = R * G * B，C' = C - B^T * G * B，都只有乘法，不会在A远小于R时相减抵消
+        V gb[4][4];
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                gb[r][c] = g[sym4_index[r][0]] * p[cova_index[0][c + 4]] + g[sym4_index[r][1]] * p[cova_index[1][c + 4]] +
+                           g[sym4_index[r][2]] * p[cova_index[2][c + 4]] + g[sym4_index[r][3]] * p[cova_index[3][c + 4]];
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            for (int c = r; c < 4; c++) {
+                V ag = p[cova_index[r][0]] * g[sym4_index[0][c]] + p[cova_index[r][1]] * g[sym4_index[1][c]] +
+                       p[cova_index[r][2]] * g[sym4_index[2][c]] + p[cova_index[r][3]] * g[sym4_index[3][c]];
+                (ag * r_diag[c]).store(cova + cova_index[r][c] * stride);
+
+                V btgb = p[cova_index[0][r + 4]] * gb[0][c] + p[cova_index[1][r + 4]] * gb[1][c] +
+                         p[cova_index[2][r + 4]] * gb[2][c] + p[cova_index[3][r + 4]] * gb[3][c];
+                (p[cova_index[r + 4][c + 4]] - btgb).store(cova + cova_index[r + 4][c + 4] * stride);
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                (r_diag[r] * gb[r][c]).store(cova + cova_index[r][c + 4] * stride);
+            }
+        }
+    }
+
+    void BatchKalmanFilter::predict(float *mean, float *cova, int n, int stride,
+                                    float std_weight_position, float std_weight_velocity) {
+        int i = 0;
+#if KALMAN_SIMD
+        for (; i + 4 <= n; i += 4) {
+            predict_lanes<Lanes4>(mean + i, cova + i, stride, std_weight_position, std_weight_velocity);
+        }
+#endif
+        for (; i < n; i++) {
+            predict_lanes<Lane1>(mean + i, cova + i, stride, std_weight_position, std_weight_velocity);
+        }
+    }
+
+    void BatchKalmanFilter::update(float *mean, float *cova, const float *measurement, int n, int stride,
+                                   float std_weight_position) {
+        int i = 0;
+#if KALMAN_SIMD
+        for (; i + 4 <= n; i += 4) {
+            update_lanes<Lanes4>(mean + i, cova + i, measurement + i, stride, std_weight_position);
+        }
+#endif
+        for (; i < n; i++) {
+            update_lanes<Lane1>(mean + i, cova + i, measurement + i, stride, std_weight_position);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include "dataType.h"
+
+namespace byte_kalman {
+    /**
+     * 4x4对称正定矩阵的闭式求逆，输入输出都是按行的上三角（10个元素）。
+     * 按2x2分块用Schur补求解，不开方、没有分支，T可以是float或者多条轨迹打包的simd类型
+     */
+    template<typename T>
+    inline void spd4_inverse(const T *s, T *inv) {
+        // S = [P Q; Q^T U]，T = P^-1 * Q，X = U - Q^T * T
+        const T det_p = s[0] * s[4] - s[1] * s[1];
+        const T p00 = s[4] / det_p, p01 = -s[1] / det_p, p11 = s[0] / det_p;
+        const T t00 = p00 * s[2] + p01 * s[5];
+        const T t01 = p00 * s[3] + p01 * s[6];
+        const T t10 = p01 * s[2] + p11 * s[5];
+        const T t11 = p01 * s[3] + p11 * s[6];
+        const T x00 = s[7] - (s[2] * t00 + s[5] * t10);
+        const T x01 = s[8] - (s[2] * t01 + s[5] * t11);
+        const T x11 = s[9] - (s[3] * t01 + s[6] * t11);
+        const T det_x = x00 * x11 - x01 * x01;
+
+        // S^-1 = [P^-1 + T * X^-1 * T^T, -T * X^-1; -X^-1 * T^T, X^-1]
+        inv[7] = x11 / det_x;
+        inv[8] = -x01 / det_x;
+        inv[9] = x00 / det_x;
+        inv[2] = -(t00 * inv[7] + t01 * inv[8]);
+        inv[3] = -(t00 * inv[8] + t01 * inv[9]);
+        inv[5] = -(t10 * inv[7] + t11 * inv[8]);
+        inv[6] = -(t10 * inv[8] + t11 * inv[9]);
+        inv[0] = p00 - (inv[2] * t00 + inv[3] * t01);
+        inv[1] = p01 - (inv[2] * t10 + inv[3] * t11);
+        inv[4] = p11 - (inv[5] * t10 + inv[6] * t11);
+    }
+
+    /**
+     * 批量卡尔曼滤波，所有轨迹的均值和协方差按SoA排列（同一个分量的各条轨迹连续存放），
+     * 预测和更新对全部轨迹做一遍循环，每次用SSE2/NEON处理4条轨迹。
+     * 运动模型为匀速模型，协方差按 [A B; B^T C] 分块（A为位置，C为速度）直接写出结果，不做8x8稠密乘法；
+     * 协方差对称，只保存上三角：A、C各10个分量，B为16个分量
+     */
+    class BatchKalmanFilter {
+    public:
+        static constexpr int mean_dim = 8;
+        static constexpr int cova_dim = 36;
+        static constexpr int measure_dim = 4;
+
+        BatchKalmanFilter();
+
+        // 轨迹数，已有数据不保留
+        void resize(int n);
+
+        int size() const { return n_; }
+
+        void set(int i, const KAL_MEAN &mean, const KAL_COVA &covariance);
+
+        void get(int i, KAL_MEAN &mean, KAL_COVA &covariance) const;
+
+        // 第i条轨迹的观测 (x, y, a, h)
+        void set_measurement(int i, const float *xyah);
+
+        void predict();
+
+        void update();
+
+        /**
+         * 直接在SoA数组上预测，第k个分量的第i条轨迹位于 mean[k * stride + i]，单条轨迹时stride为1
+         */
+        static void predict(float *mean, float *cova, int n, int stride,
+                            float std_weight_position, float std_weight_velocity);
+
+        /**
+         * 直接在SoA数组上更新，measurement同样按 measurement[k * stride + i] 排列。
+         * 新息协方差用spd4_inverse直接求逆，协方差按 A' = A*G*R、B' = R*G*B、C' = C - B^T*G*B 更新
+         */
+        static void update(float *mean, float *cova, const float *measurement, int n, int stride,
+                           float std_weight_position);
+
+        // KAL_COVA与压缩上三角之间的转换
+        static void pack_covariance(const KAL_COVA &covariance, float *cova, int stride);
+
+        static void unpack_covariance(const float *cova, int stride, KAL_COVA &covariance);
+
+    private:
+        int n_;
+        float std_weight_position_;
+        float std_weight_velocity_;
+        std::vector<float> mean_;
+        std::vector<float> cova_;
+        std::vector<float> measurement_;
+    };
+}
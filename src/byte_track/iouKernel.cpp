@@ -0,0 +1,226 @@
+#include "iouKernel.h"
+#include <algorithm>
+#include <ncnn/cpu.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IOU_X86 1
+#include <immintrin.h>
+#else
+#define IOU_X86 0
+#endif
+
+#if __ARM_NEON && __aarch64__
+#include <arm_neon.h>
+#endif
+
+// gcc/clang需要为单个函数打开指令集，msvc的intrinsic不需要编译选项；不打开fma，保证与标量结果一致
+// 编译器仍可能把mul+add合并成fma（-march=native、aarch64），需要-ffp-contract=off
+#if defined(__GNUC__) || defined(__clang__)
+#define IOU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IOU_TARGET(isa)
+#endif
+
+void TlbrBoxes::resize(int n) {
+    x1.resize(n);
+    y1.resize(n);
+    x2.resize(n);
+    y2.resize(n);
+    area.resize(n);
+}
+
+void TlbrBoxes::set(int i, const float *tlbr) {
+    x1[i] = tlbr[0];
+    y1[i] = tlbr[1];
+    x2[i] = tlbr[2];
+    y2[i] = tlbr[3];
+    area[i] = (tlbr[2] - tlbr[0] + 1) * (tlbr[3] - tlbr[1] + 1);
+}
+
+// 与tlbr_iou_distance相同的运算顺序
+static inline float iou_distance_one(float ax1, float ay1, float ax2, float ay2, float aarea,
+                                     float bx1, float by1, float bx2, float by2, float barea) {
+    float iou = 0.0;
+    float iw = std::min(ax2, bx2) - std::max(ax1, bx1) + 1;
+    if (iw > 0) {
+        float ih = std::min(ay2, by2) - std::max(ay1, by1) + 1;
+        if (ih > 0) {
+            float ua = aarea + barea - iw * ih;
+            iou = iw * ih / ua;
+        }
+    }
+    return 1 - iou;
+}
+
+static void iou_row_scalar(const TlbrBoxes &a, int n, const TlbrBoxes &b, int k0, float *row) {
+    const int cols = b.size();
+    for (int k = k0; k < cols; k++) {
+        row[k] = iou_distance_one(a.x1[n], a.y1[n], a.x2[n], a.y2[n], a.area[n],
+                                  b.x1[k], b.y1[k], b.x2[k], b.y2[k], b.area[k]);
+    }
+}
+
+void iou_distance_matrix_scalar(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    const int rows = a.size();
+    const int cols = b.size();
+    for (int n = 0; n < rows; n++) {
+        iou_row_scalar(a, n, b, 0, cost + (size_t) n * cols);
+    }
+}
+
+#if IOU_X86
+static void iou_matrix_sse2(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    const int rows = a.size();
+    const int cols = b.size();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 zero = _mm_setzero_ps();
+    for (int n = 0; n < rows; n++) {
+        float *row = cost + (size_t) n * cols;
+        const __m128 ax1 = _mm_set1_ps(a.x1[n]);
+        const __m128 ay1 = _mm_set1_ps(a.y1[n]);
+        const __m128 ax2 = _mm_set1_ps(a.x2[n]);
+        const __m128 ay2 = _mm_set1_ps(a.y2[n]);
+        const __m128 aarea = _mm_set1_ps(a.area[n]);
+        int k = 0;
+        for (; k + 3 < cols; k += 4) {
+            __m128 iw = _mm_add_ps(_mm_sub_ps(_mm_min_ps(ax2, _mm_loadu_ps(&b.x2[k])),
+                                              _mm_max_ps(ax1, _mm_loadu_ps(&b.x1[k]))), one);
+            __m128 ih = _mm_add_ps(_mm_sub_ps(_mm_min_ps(ay2, _mm_loadu_ps(&b.y2[k])),
+                                              _mm_max_ps(ay1, _mm_loadu_ps(&b.y1[k]))), one);
+            __m128 inter = _mm_mul_ps(iw, ih);
+            __m128 ua = _mm_sub_ps(_mm_add_ps(aarea, _mm_loadu_ps(&b.area[k])), inter);
+            __m128 mask = _mm_and_ps(_mm_cmpgt_ps(iw, zero), _mm_cmpgt_ps(ih, zero));
+            __m128 iou = _mm_and_ps(mask, _mm_div_ps(inter, ua));
+            _mm_storeu_ps(row + k, _mm_sub_ps(one, iou));
+        }
+        iou_row_scalar(a, n, b, k, row);
+    }
+}
+
+IOU_TARGET("avx")
+static void iou_matrix_avx(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    const int rows = a.size();
+    const int cols = b.size();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 zero = _mm256_setzero_ps();
+    for (int n = 0; n < rows; n++) {
+        float *row = cost + (size_t) n * cols;
+        const __m256 ax1 = _mm256_set1_ps(a.x1[n]);
+        const __m256 ay1 = _mm256_set1_ps(a.y1[n]);
+        const __m256 ax2 = _mm256_set1_ps(a.x2[n]);
+        const __m256 ay2 = _mm256_set1_ps(a.y2[n]);
+        const __m256 aarea = _mm256_set1_ps(a.area[n]);
+        int k = 0;
+        for (; k + 7 < cols; k += 8) {
+            __m256 iw = _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(ax2, _mm256_loadu_ps(&b.x2[k])),
+                                                    _mm256_max_ps(ax1, _mm256_loadu_ps(&b.x1[k]))), one);
+            __m256 ih = _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(ay2, _mm256_loadu_ps(&b.y2[k])),
+                                                    _mm256_max_ps(ay1, _mm256_loadu_ps(&b.y1[k]))), one);
+            __m256 inter = _mm256_mul_ps(iw, ih);
+            __m256 ua = _mm256_sub_ps(_mm256_add_ps(aarea, _mm256_loadu_ps(&b.area[k])), inter);
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(iw, zero, _CMP_GT_OQ), _mm256_cmp_ps(ih, zero, _CMP_GT_OQ));
+            __m256 iou = _mm256_and_ps(mask, _mm256_div_ps(inter, ua));
+            _mm256_storeu_ps(row + k, _mm256_sub_ps(one, iou));
+        }
+        iou_row_scalar(a, n, b, k, row);
+    }
+}
+
+IOU_TARGET("avx512f")
+static void iou_matrix_avx512(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    const int rows = a.size();
+    const int cols = b.size();
+    const __m512 one = _mm512_set1_ps(1.f);
+    const __m512 zero = _mm512_setzero_ps();
+    for (int n = 0; n < rows; n++) {
+        float *row = cost + (size_t) n * cols;
+        const __m512 ax1 = _mm512_set1_ps(a.x1[n]);
+        const __m512 ay1 = _mm512_set1_ps(a.y1[n]);
+        const __m512 ax2 = _mm512_set1_ps(a.x2[n]);
+        const __m512 ay2 = _mm512_set1_ps(a.y2[n]);
+        const __m512 aarea = _mm512_set1_ps(a.area[n]);
+        // 尾部用掩码读写，不需要标量收尾
+        for (int k = 0; k < cols; k += 16) {
+            const __mmask16 lanes = cols - k >= 16 ? (__mmask16) 0xffff : (__mmask16) ((1u << (cols - k)) - 1);
+            __m512 bx1 = _mm512_maskz_loadu_ps(lanes, &b.x1[k]);
+            __m512 by1 = _mm512_maskz_loadu_ps(lanes, &b.y1[k]);
+            __m512 bx2 = _mm512_maskz_loadu_ps(lanes, &b.x2[k]);
+            __m512 by2 = _mm512_maskz_loadu_ps(lanes, &b.y2[k]);
+            __m512 barea = _mm512_maskz_loadu_ps(lanes, &b.area[k]);
+            __m512 iw = _mm512_add_ps(_mm512_sub_ps(_mm512_min_ps(ax2, bx2), _mm512_max_ps(ax1, bx1)), one);
+            __m512 ih = _mm512_add_ps(_mm512_sub_ps(_mm512_min_ps(ay2, by2), _mm512_max_ps(ay1, by1)), one);
+            __m512 inter = _mm512_mul_ps(iw, ih);
+            __m512 ua = _mm512_sub_ps(_mm512_add_ps(aarea, barea), inter);
+            __mmask16 valid = _mm512_cmp_ps_mask(iw, zero, _CMP_GT_OQ) & _mm512_cmp_ps_mask(ih, zero, _CMP_GT_OQ);
+            __m512 iou = _mm512_maskz_div_ps(valid, inter, ua);
+            _mm512_mask_storeu_ps(row + k, lanes, _mm512_sub_ps(one, iou));
+        }
+    }
+}
+#endif // IOU_X86
+
+#if __ARM_NEON && __aarch64__
+static void iou_matrix_neon(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    const int rows = a.size();
+    const int cols = b.size();
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    for (int n = 0; n < rows; n++) {
+        float *row = cost + (size_t) n * cols;
+        const float32x4_t ax1 = vdupq_n_f32(a.x1[n]);
+        const float32x4_t ay1 = vdupq_n_f32(a.y1[n]);
+        const float32x4_t ax2 = vdupq_n_f32(a.x2[n]);
+        const float32x4_t ay2 = vdupq_n_f32(a.y2[n]);
+        const float32x4_t aarea = vdupq_n_f32(a.area[n]);
+        int k = 0;
+        for (; k + 3 < cols; k += 4) {
+            float32x4_t iw = vaddq_f32(vsubq_f32(vminq_f32(ax2, vld1q_f32(&b.x2[k])),
+                                                 vmaxq_f32(ax1, vld1q_f32(&b.x1[k]))), one);
+            float32x4_t ih = vaddq_f32(vsubq_f32(vminq_f32(ay2, vld1q_f32(&b.y2[k])),
+                                                 vmaxq_f32(ay1, vld1q_f32(&b.y1[k]))), one);
+            float32x4_t inter = vmulq_f32(iw, ih);
+            float32x4_t ua = vsubq_f32(vaddq_f32(aarea, vld1q_f32(&b.area[k])), inter);
+            uint32x4_t mask = vandq_u32(vcgtq_f32(iw, zero), vcgtq_f32(ih, zero));
+            float32x4_t iou = vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(vdivq_f32(inter, ua))));
+            vst1q_f32(row + k, vsubq_f32(one, iou));
+        }
+        iou_row_scalar(a, n, b, k, row);
+    }
+}
+#endif
+
+typedef void (*iou_matrix_func)(const TlbrBoxes &, const TlbrBoxes &, float *);
+
+struct IouKernel {
+    iou_matrix_func func;
+    const char *name;
+};
+
+static IouKernel select_iou_kernel() {
+#if IOU_X86
+    if (ncnn::cpu_support_x86_avx512()) {
+        return {iou_matrix_avx512, "avx512"};
+    }
+    if (ncnn::cpu_support_x86_avx()) {
+        return {iou_matrix_avx, "avx"};
+    }
+    return {iou_matrix_sse2, "sse2"};
+#elif __ARM_NEON && __aarch64__
+    return {iou_matrix_neon, "neon"};
+#else
+    return {iou_distance_matrix_scalar, "scalar"};
+#endif
+}
+
+static const IouKernel &iou_kernel() {
+    static const IouKernel kernel = select_iou_kernel();
+    return kernel;
+}
+
+void iou_distance_matrix(const TlbrBoxes &a, const TlbrBoxes &b, float *cost) {
+    iou_kernel().func(a, b, cost);
+}
+
+const char *iou_kernel_name() {
+    return iou_kernel().name;
+}
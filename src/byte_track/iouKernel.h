@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * SoA排列的tlbr框，area为 (x2 - x1 + 1) * (y2 - y1 + 1)
+ */
+struct TlbrBoxes {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> area;
+
+    void resize(int n);
+
+    // 写入第i个框并计算面积
+    void set(int i, const float *tlbr);
+
+    int size() const { return (int) x1.size(); }
+};
+
+/**
+ * IoU距离矩阵 cost[n * cols + k] = 1 - IoU(a[n], b[k])，每次对b做一遍SIMD扫描得到一整行，
+ * 运行时按cpu选择AVX-512/AVX/SSE2（x86）或NEON（aarch64），结果与标量实现逐位一致，
+ * 前提是编译时不把乘加合并成fma（CMakeLists.txt中的-ffp-contract=off）
+ */
+void iou_distance_matrix(const TlbrBoxes &a, const TlbrBoxes &b, float *cost);
+
+// 标量参考实现
+void iou_distance_matrix_scalar(const TlbrBoxes &a, const TlbrBoxes &b, float *cost);
+
+// 当前使用的实现：avx512/avx/sse2/neon/scalar
+const char *iou_kernel_name();
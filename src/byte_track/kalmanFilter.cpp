@@ -1,5 +1,5 @@
 #include "kalmanFilter.h"
-#include <Eigen/Cholesky>
+#include "batchKalmanFilter.h"
 
 namespace byte_kalman {
     const double KalmanFilter::chi2inv95[10] = {
@@ -16,15 +16,7 @@ namespace byte_kalman {
     };
 
     KalmanFilter::KalmanFilter() {
-        int ndim = 4;
-        double dt = 1.;
-
-        _motion_mat = Eigen::MatrixXf::Identity(8, 8);
-        for (int i = 0; i < ndim; i++) {
-            _motion_mat(i, ndim + i) = dt;
-        }
-        _update_mat = Eigen::MatrixXf::Identity(4, 8);
-
+        // 运动矩阵为 [I I; 0 I]（dt = 1），观测矩阵取前4个状态，都已经展开在BatchKalmanFilter的计算里
         this->_std_weight_position = 1. / 20;
         this->_std_weight_velocity = 1. / 160;
     }
@@ -56,40 +48,29 @@ namespace byte_kalman {
     }
 
     void KalmanFilter::predict(KAL_MEAN &mean, KAL_COVA &covariance) {
-        //revise the data;
-        DETECTBOX std_pos;
-        std_pos << _std_weight_position * mean(3),
-                _std_weight_position * mean(3),
-                1e-2,
-                _std_weight_position * mean(3);
-        DETECTBOX std_vel;
-        std_vel << _std_weight_velocity * mean(3),
-                _std_weight_velocity * mean(3),
-                1e-5,
-                _std_weight_velocity * mean(3);
-        KAL_MEAN tmp;
-        tmp.block<1, 4>(0, 0) = std_pos;
-        tmp.block<1, 4>(0, 4) = std_vel;
-        tmp = tmp.array().square();
-        KAL_COVA motion_cov = tmp.asDiagonal();
-        KAL_MEAN mean1 = this->_motion_mat * mean.transpose();
-        KAL_COVA covariance1 = this->_motion_mat * covariance * (_motion_mat.transpose());
-        covariance1 += motion_cov;
-
-        mean = mean1;
-        covariance = covariance1;
+        float m[BatchKalmanFilter::mean_dim];
+        float c[BatchKalmanFilter::cova_dim];
+        for (int i = 0; i < BatchKalmanFilter::mean_dim; i++) m[i] = mean(i);
+        BatchKalmanFilter::pack_covariance(covariance, c, 1);
+        BatchKalmanFilter::predict(m, c, 1, 1, _std_weight_position, _std_weight_velocity);
+        for (int i = 0; i < BatchKalmanFilter::mean_dim; i++) mean(i) = m[i];
+        BatchKalmanFilter::unpack_covariance(c, 1, covariance);
     }
 
     KAL_HDATA KalmanFilter::project(const KAL_MEAN &mean, const KAL_COVA &covariance) {
-        DETECTBOX std;
-        std << _std_weight_position * mean(3), _std_weight_position * mean(3),
-                1e-1, _std_weight_position * mean(3);
-        KAL_HMEAN mean1 = _update_mat * mean.transpose();
-        KAL_HCOVA covariance1 = _update_mat * covariance * (_update_mat.transpose());
-        Eigen::Matrix<float, 4, 4> diag = std.asDiagonal();
-        diag = diag.array().square().matrix();
-        covariance1 += diag;
-        //    covariance1.diagonal() << diag;
+        const float std_pos = _std_weight_position * mean(3);
+        const float var[4] = {std_pos * std_pos, std_pos * std_pos, 1e-1f * 1e-1f, std_pos * std_pos};
+
+        // H * x 为位置，H * P * H^T 为位置块A
+        KAL_HMEAN mean1;
+        KAL_HCOVA covariance1;
+        for (int r = 0; r < 4; r++) {
+            mean1(r) = mean(r);
+            for (int c = 0; c < 4; c++) {
+                covariance1(r, c) = covariance(r, c);
+            }
+            covariance1(r, r) += var[r];
+        }
         return std::make_pair(mean1, covariance1);
     }
 
@@ -98,22 +79,18 @@ namespace byte_kalman {
             const KAL_MEAN &mean,
             const KAL_COVA &covariance,
             const DETECTBOX &measurement) {
-        KAL_HDATA pa = project(mean, covariance);
-        KAL_HMEAN projected_mean = pa.first;
-        KAL_HCOVA projected_cov = pa.second;
+        float m[BatchKalmanFilter::mean_dim];
+        float c[BatchKalmanFilter::cova_dim];
+        float z[BatchKalmanFilter::measure_dim];
+        for (int i = 0; i < BatchKalmanFilter::mean_dim; i++) m[i] = mean(i);
+        for (int i = 0; i < BatchKalmanFilter::measure_dim; i++) z[i] = measurement(i);
+        BatchKalmanFilter::pack_covariance(covariance, c, 1);
+        BatchKalmanFilter::update(m, c, z, 1, 1, _std_weight_position);
 
-        //chol_factor, lower =
-        //scipy.linalg.cho_factor(projected_cov, lower=True, check_finite=False)
-        //kalmain_gain =
-        //scipy.linalg.cho_solve((cho_factor, lower),
-        //np.dot(covariance, self._upadte_mat.T).T,
-        //check_finite=False).T
-        Eigen::Matrix<float, 4, 8> B = (covariance * (_update_mat.transpose())).transpose();
-        Eigen::Matrix<float, 8, 4> kalman_gain = (projected_cov.llt().solve(B)).transpose(); // eg.8x4
-        Eigen::Matrix<float, 1, 4> innovation = measurement - projected_mean; //eg.1x4
-        auto tmp = innovation * (kalman_gain.transpose());
-        KAL_MEAN new_mean = (mean.array() + tmp.array()).matrix();
-        KAL_COVA new_covariance = covariance - kalman_gain * projected_cov * (kalman_gain.transpose());
+        KAL_MEAN new_mean;
+        KAL_COVA new_covariance;
+        for (int i = 0; i < BatchKalmanFilter::mean_dim; i++) new_mean(i) = m[i];
+        BatchKalmanFilter::unpack_covariance(c, 1, new_covariance);
         return std::make_pair(new_mean, new_covariance);
     }
 
@@ -131,16 +108,32 @@ namespace byte_kalman {
         KAL_HMEAN mean1 = pa.first;
         KAL_HCOVA covariance1 = pa.second;
 
-        //    Eigen::Matrix<float, -1, 4, Eigen::RowMajor> d(size, 4);
-        DETECTBOXSS d(measurements.size(), 4);
-        int pos = 0;
-        for (DETECTBOX box: measurements) {
-            d.row(pos++) = box - mean1;
+        // 马氏距离 d^T * S^-1 * d，S^-1用闭式求逆
+        float s[10], inv[10];
+        int k = 0;
+        for (int r = 0; r < 4; r++) {
+            for (int c = r; c < 4; c++) {
+                s[k++] = covariance1(r, c);
+            }
+        }
+        spd4_inverse(s, inv);
+
+        Eigen::Matrix<float, 1, -1> square_maha(1, measurements.size());
+        for (int i = 0; i < measurements.size(); i++) {
+            float d[4];
+            for (int r = 0; r < 4; r++) {
+                d[r] = measurements[i](r) - mean1(r);
+            }
+            float sum = 0;
+            k = 0;
+            for (int r = 0; r < 4; r++) {
+                sum += inv[k++] * d[r] * d[r];
+                for (int c = r + 1; c < 4; c++) {
+                    sum += 2 * inv[k++] * d[r] * d[c];
+                }
+            }
+            square_maha(i) = sum;
         }
-        Eigen::Matrix<float, -1, -1, Eigen::RowMajor> factor = covariance1.llt().matrixL();
-        Eigen::Matrix<float, -1, -1> z = factor.triangularView<Eigen::Lower>().solve<Eigen::OnTheRight>(d).transpose();
-        auto zz = ((z.array()) * (z.array())).matrix();
-        auto square_maha = zz.colwise().sum();
         return square_maha;
     }
-}
\ No newline at end of file
+}
@@ -11,6 +11,7 @@ namespace byte_kalman {
 
         KAL_DATA initiate(const DETECTBOX &measurement);
 
+        // 单条轨迹的预测和更新，与BatchKalmanFilter使用同一套计算
         void predict(KAL_MEAN &mean, KAL_COVA &covariance);
 
         KAL_HDATA project(const KAL_MEAN &mean, const KAL_COVA &covariance);
@@ -26,8 +27,6 @@ namespace byte_kalman {
                 bool only_position = false);
 
     private:
-        Eigen::Matrix<float, 8, 8, Eigen::RowMajor> _motion_mat;
-        Eigen::Matrix<float, 4, 8, Eigen::RowMajor> _update_mat;
         float _std_weight_position;
         float _std_weight_velocity;
     };
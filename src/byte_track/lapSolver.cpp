@@ -0,0 +1,175 @@
+#include "lapSolver.h"
+#include <algorithm>
+
+double LapSolver::solve(const float *cost, int rows, int cols, std::vector<int> &rowsol, std::vector<int> &colsol,
+                        float cost_limit) {
+    rowsol.assign(rows, -1);
+    colsol.assign(cols, -1);
+    if (rows == 0 || cols == 0) {
+        return 0.0;
+    }
+
+    // 有阈值时，没有任何可匹配配对的行和列不参与求解，IoU矩阵通常大部分行列都能去掉
+    const bool limited = cost_limit < std::numeric_limits<float>::infinity();
+    rows_.clear();
+    cols_.clear();
+    if (limited) {
+        sc_.assign(cols, 0);
+        for (int i = 0; i < rows; i++) {
+            const float *row = cost + (size_t) i * cols;
+            bool any = false;
+            for (int j = 0; j < cols; j++) {
+                if (row[j] < cost_limit) {
+                    any = true;
+                    sc_[j] = 1;
+                }
+            }
+            if (any) {
+                rows_.push_back(i);
+            }
+        }
+        for (int j = 0; j < cols; j++) {
+            if (sc_[j]) {
+                cols_.push_back(j);
+            }
+        }
+    } else {
+        for (int i = 0; i < rows; i++) {
+            rows_.push_back(i);
+        }
+        for (int j = 0; j < cols; j++) {
+            cols_.push_back(j);
+        }
+    }
+
+    const int nr = rows_.size();
+    const int nc = cols_.size();
+    if (nr == 0 || nc == 0) {
+        return 0.0;
+    }
+
+    // 算法要求行数不大于列数，否则在转置后的问题上求解
+    const bool transposed = nr > nc;
+    if (!transposed) {
+        col4row_.resize(nr);
+        augment(cost, rows_.data(), cols_.data(), cols, 1, nr, nc, limited, cost_limit, col4row_.data());
+    } else {
+        col4row_.resize(nc);
+        augment(cost, cols_.data(), rows_.data(), 1, cols, nc, nr, limited, cost_limit, col4row_.data());
+    }
+
+    double opt = 0.0;
+    const int n = transposed ? nc : nr;
+    for (int r = 0; r < n; r++) {
+        if (col4row_[r] < 0) {
+            continue;
+        }
+        const int i = transposed ? rows_[col4row_[r]] : rows_[r];
+        const int j = transposed ? cols_[r] : cols_[col4row_[r]];
+        const float c = cost[(size_t) i * cols + j];
+        if (limited && c >= cost_limit) {
+            continue;
+        }
+        rowsol[i] = j;
+        colsol[j] = i;
+        opt += c;
+    }
+    return opt;
+}
+
+void LapSolver::augment(const float *cost, const int *row_map, const int *col_map, int row_stride, int col_stride,
+                        int nr, int nc, bool limited, float cost_limit, int *col4row) {
+    const double inf = std::numeric_limits<double>::infinity();
+
+    u_.assign(nr, 0.0);
+    v_.assign(nc, 0.0);
+    shortest_.resize(nc);
+    path_.assign(nc, -1);
+    row4col_.assign(nc, -1);
+    remaining_.resize(nc);
+    sr_.resize(nr);
+    sc_.resize(nc);
+    std::fill(col4row, col4row + nr, -1);
+
+    for (int cur_row = 0; cur_row < nr; cur_row++) {
+        // 以cur_row为起点的Dijkstra，找到一条到未匹配列的最短增广路
+        double min_val = 0;
+        int i = cur_row;
+        int num_remaining = nc;
+        for (int it = 0; it < nc; it++) {
+            remaining_[it] = nc - it - 1;
+        }
+        std::fill(sr_.begin(), sr_.end(), 0);
+        std::fill(sc_.begin(), sc_.end(), 0);
+        std::fill(shortest_.begin(), shortest_.end(), inf);
+
+        int sink = -1;
+        while (sink == -1) {
+            int index = -1;
+            double lowest = inf;
+            sr_[i] = 1;
+
+            const float *row = cost + (size_t) row_map[i] * row_stride;
+            const double ui = u_[i];
+            for (int it = 0; it < num_remaining; it++) {
+                const int j = remaining_[it];
+                float c = row[(size_t) col_map[j] * col_stride];
+                if (limited) {
+                    c = std::min(c - cost_limit, 0.f);
+                }
+                const double r = min_val + c - ui - v_[j];
+                if (r < shortest_[j]) {
+                    path_[j] = i;
+                    shortest_[j] = r;
+                }
+                // 距离相同时优先选未匹配的列，稀疏的IoU矩阵大多一步就能结束
+                if (shortest_[j] < lowest || (shortest_[j] == lowest && row4col_[j] == -1)) {
+                    lowest = shortest_[j];
+                    index = it;
+                }
+            }
+
+            min_val = lowest;
+            if (index < 0 || min_val == inf) {
+                break; // 不可行，该行不匹配
+            }
+
+            const int j = remaining_[index];
+            if (row4col_[j] == -1) {
+                sink = j;
+            } else {
+                i = row4col_[j];
+            }
+            sc_[j] = 1;
+            remaining_[index] = remaining_[--num_remaining];
+        }
+
+        if (sink < 0) {
+            continue;
+        }
+
+        // 更新对偶变量
+        u_[cur_row] += min_val;
+        for (int r = 0; r < nr; r++) {
+            if (sr_[r] && r != cur_row) {
+                u_[r] += min_val - shortest_[col4row[r]];
+            }
+        }
+        for (int c = 0; c < nc; c++) {
+            if (sc_[c]) {
+                v_[c] -= min_val - shortest_[c];
+            }
+        }
+
+        // 沿路径增广
+        int j = sink;
+        while (true) {
+            const int r = path_[j];
+            row4col_[j] = r;
+            std::swap(col4row[r], j);
+            if (r == cur_row) {
+                break;
+            }
+        }
+    }
+}
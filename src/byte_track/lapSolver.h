@@ -0,0 +1,40 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+/**
+ * 矩形线性指派问题的最短增广路求解器（Crouse 2016，与scipy的linear_sum_assignment相同的算法）
+ * 直接处理 rows != cols，不需要像lapjv那样扩展成 (rows+cols) 的方阵；
+ * 阈值通过 c' = min(c - cost_limit, 0) 处理，与lapjv用cost_limit/2填充扩展矩阵的结果等价。
+ * 代价矩阵原地读取，工作区在多次调用之间复用
+ */
+class LapSolver {
+public:
+    /**
+     * @param cost 行优先的代价矩阵，rows x cols
+     * @param cost_limit 代价不小于cost_limit的配对不匹配，默认不限制
+     * @param rowsol 每行匹配的列，未匹配为-1
+     * @param colsol 每列匹配的行，未匹配为-1
+     * @return 匹配上的配对的代价之和
+     */
+    double solve(const float *cost, int rows, int cols, std::vector<int> &rowsol, std::vector<int> &colsol,
+                 float cost_limit = std::numeric_limits<float>::infinity());
+
+private:
+    // 在压缩后的 nr x nc 子问题上求解，nr <= nc，元素(r, c)位于 cost[row_map[r] * row_stride + col_map[c] * col_stride]
+    void augment(const float *cost, const int *row_map, const int *col_map, int row_stride, int col_stride,
+                 int nr, int nc, bool limited, float cost_limit, int *col4row);
+
+    std::vector<int> rows_;
+    std::vector<int> cols_;
+    std::vector<int> col4row_;
+    std::vector<int> row4col_;
+    std::vector<int> path_;
+    std::vector<int> remaining_;
+    std::vector<double> u_;
+    std::vector<double> v_;
+    std::vector<double> shortest_;
+    std::vector<char> sr_;
+    std::vector<char> sc_;
+};
@@ -0,0 +1,251 @@
+#include "sparseAssociation.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+void SparseAssociation::solve(const float *atlbrs, int rows, const float *btlbrs, int cols, float thresh,
+                              std::vector<int> &rowsol, std::vector<int> &colsol, int num_threads) {
+    rowsol.assign(rows, -1);
+    colsol.assign(cols, -1);
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    build_grid(btlbrs, cols);
+    find_edges(atlbrs, rows, btlbrs, thresh);
+    if (edges_.empty()) {
+        return;
+    }
+
+    // 并查集，节点0..rows-1为行，rows..rows+cols-1为列
+    const int num_nodes = rows + cols;
+    parent_.resize(num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+        parent_[i] = i;
+    }
+    for (int k = 0; k < edges_.size(); k++) {
+        int ra = find_root(edges_[k].row);
+        int rb = find_root(rows + edges_[k].col);
+        if (ra != rb) {
+            parent_[rb] = ra;
+        }
+    }
+
+    // 按分量对边做计数排序，分量按第一次出现的行排序
+    comp_id_.assign(num_nodes, -1);
+    int num_comps = 0;
+    for (int k = 0; k < edges_.size(); k++) {
+        int root = find_root(edges_[k].row);
+        if (comp_id_[root] < 0) {
+            comp_id_[root] = num_comps++;
+        }
+    }
+    comp_start_.assign(num_comps + 1, 0);
+    for (int k = 0; k < edges_.size(); k++) {
+        comp_start_[comp_id_[find_root(edges_[k].row)] + 1]++;
+    }
+    for (int c = 0; c < num_comps; c++) {
+        comp_start_[c + 1] += comp_start_[c];
+    }
+    comp_edges_.resize(edges_.size());
+    fill_pos_.assign(comp_start_.begin(), comp_start_.end() - 1);
+    for (int k = 0; k < edges_.size(); k++) {
+        comp_edges_[fill_pos_[comp_id_[find_root(edges_[k].row)]]++] = k;
+    }
+
+    // 各分量的节点互不相交，local_index_可以在线程之间共用
+    local_index_.assign(num_nodes, -1);
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if (workers_.size() < num_threads) {
+        workers_.resize(num_threads);
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1 && num_comps > 1)
+    for (int c = 0; c < num_comps; c++) {
+        const int begin = comp_start_[c];
+        const int end = comp_start_[c + 1];
+
+        // 只有一对候选时直接匹配
+        if (end - begin == 1) {
+            const Edge &e = edges_[comp_edges_[begin]];
+            rowsol[e.row] = e.col;
+            colsol[e.col] = e.row;
+            continue;
+        }
+
+#ifdef _OPENMP
+        Worker &w = workers_[omp_get_thread_num()];
+#else
+        Worker &w = workers_[0];
+#endif
+        // 边按行升序排列，行天然有序；列排序后再编号，与稠密矩阵中的相对顺序一致
+        w.rows.clear();
+        w.cols.clear();
+        for (int k = begin; k < end; k++) {
+            const Edge &e = edges_[comp_edges_[k]];
+            if (local_index_[e.row] < 0) {
+                local_index_[e.row] = w.rows.size();
+                w.rows.push_back(e.row);
+            }
+            if (local_index_[rows + e.col] < 0) {
+                local_index_[rows + e.col] = 0;
+                w.cols.push_back(e.col);
+            }
+        }
+        std::sort(w.cols.begin(), w.cols.end());
+        for (int j = 0; j < w.cols.size(); j++) {
+            local_index_[rows + w.cols[j]] = j;
+        }
+
+        const int nr = w.rows.size();
+        const int nc = w.cols.size();
+        w.cost.assign((size_t) nr * nc, 1.f);
+        for (int k = begin; k < end; k++) {
+            const Edge &e = edges_[comp_edges_[k]];
+            w.cost[(size_t) local_index_[e.row] * nc + local_index_[rows + e.col]] = e.cost;
+        }
+
+        w.solver.solve(w.cost.data(), nr, nc, w.rowsol, w.colsol, thresh);
+        for (int r = 0; r < nr; r++) {
+            if (w.rowsol[r] >= 0) {
+                rowsol[w.rows[r]] = w.cols[w.rowsol[r]];
+                colsol[w.cols[w.rowsol[r]]] = w.rows[r];
+            }
+        }
+    }
+}
+
+void SparseAssociation::pairs(const float *atlbrs, int rows, const float *btlbrs, int cols, float thresh,
+                              std::vector<std::pair<int, int> > &out) {
+    out.clear();
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    build_grid(btlbrs, cols);
+    find_edges(atlbrs, rows, btlbrs, thresh);
+    for (int k = 0; k < edges_.size(); k++) {
+        out.push_back(std::pair<int, int>(edges_[k].row, edges_[k].col));
+    }
+}
+
+void SparseAssociation::build_grid(const float *btlbrs, int cols) {
+    // IoU按+1像素计算，框覆盖[x1, x2 + 1)
+    float min_x = btlbrs[0], min_y = btlbrs[1];
+    float max_x = btlbrs[2] + 1, max_y = btlbrs[3] + 1;
+    float size_sum = 0;
+    for (int j = 0; j < cols; j++) {
+        const float *b = btlbrs + j * 4;
+        min_x = std::min(min_x, b[0]);
+        min_y = std::min(min_y, b[1]);
+        max_x = std::max(max_x, b[2] + 1);
+        max_y = std::max(max_y, b[3] + 1);
+        size_sum += std::max(b[2] - b[0], b[3] - b[1]) + 1;
+    }
+
+    num_cols_ = cols;
+
+    // 格子边长取框的平均尺寸，格子总数限制在框数的几倍以内
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    cell_size_ = std::max(size_sum / cols, 1.f);
+    const long long max_cells = 4LL * cols + 64;
+    while (true) {
+        grid_w_ = (int) ((max_x - min_x) / cell_size_) + 1;
+        grid_h_ = (int) ((max_y - min_y) / cell_size_) + 1;
+        if ((long long) grid_w_ * grid_h_ <= max_cells) {
+            break;
+        }
+        cell_size_ *= 2;
+    }
+
+    // 两遍计数排序建立CSR
+    cell_start_.assign((size_t) grid_w_ * grid_h_ + 1, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int j = 0; j < cols; j++) {
+            const float *b = btlbrs + j * 4;
+            int cx0, cy0, cx1, cy1;
+            cell_range(b, cx0, cy0, cx1, cy1);
+            for (int cy = cy0; cy <= cy1; cy++) {
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    const int cell = cy * grid_w_ + cx;
+                    if (pass == 0) {
+                        cell_start_[cell + 1]++;
+                    } else {
+                        cell_items_[fill_pos_[cell]++] = j;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int c = 0; c < grid_w_ * grid_h_; c++) {
+                cell_start_[c + 1] += cell_start_[c];
+            }
+            cell_items_.resize(cell_start_.back());
+            fill_pos_.assign(cell_start_.begin(), cell_start_.end() - 1);
+        }
+    }
+}
+
+// 先在浮点上截断再转int，坐标异常大或为NaN时不会溢出
+static inline int cell_coord(float v, float origin, float cell_size, int n) {
+    float c = (v - origin) / cell_size;
+    if (!(c >= 0)) {
+        return 0;
+    }
+    if (c >= n - 1) {
+        return n - 1;
+    }
+    return (int) c;
+}
+
+void SparseAssociation::cell_range(const float *box, int &cx0, int &cy0, int &cx1, int &cy1) const {
+    cx0 = cell_coord(box[0], origin_x_, cell_size_, grid_w_);
+    cy0 = cell_coord(box[1], origin_y_, cell_size_, grid_h_);
+    cx1 = cell_coord(box[2] + 1, origin_x_, cell_size_, grid_w_);
+    cy1 = cell_coord(box[3] + 1, origin_y_, cell_size_, grid_h_);
+}
+
+void SparseAssociation::find_edges(const float *atlbrs, int rows, const float *btlbrs, float thresh) {
+    edges_.clear();
+    col_stamp_.assign(num_cols_, -1);
+
+    for (int i = 0; i < rows; i++) {
+        const float *a = atlbrs + i * 4;
+        int cx0, cy0, cx1, cy1;
+        cell_range(a, cx0, cy0, cx1, cy1);
+
+        const size_t first = edges_.size();
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                const int cell = cy * grid_w_ + cx;
+                for (int k = cell_start_[cell]; k < cell_start_[cell + 1]; k++) {
+                    const int j = cell_items_[k];
+                    if (col_stamp_[j] == i) {
+                        continue;
+                    }
+                    col_stamp_[j] = i;
+                    float cost = tlbr_iou_distance(a, btlbrs + j * 4);
+                    if (cost < thresh) {
+                        Edge e = {i, j, cost};
+                        edges_.push_back(e);
+                    }
+                }
+            }
+        }
+        std::sort(edges_.begin() + first, edges_.end(), [](const Edge &x, const Edge &y) {
+            return x.col < y.col;
+        });
+    }
+}
+
+int SparseAssociation::find_root(int x) {
+    while (parent_[x] != x) {
+        parent_[x] = parent_[parent_[x]];
+        x = parent_[x];
+    }
+    return x;
+}
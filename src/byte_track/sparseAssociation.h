@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "lapSolver.h"
+
+/**
+ * 两个tlbr框的IoU距离（1 - IoU），宽高按+1像素计算，与BYTETracker::iou_distance一致
+ */
+inline float tlbr_iou_distance(const float *a, const float *b) {
+    float box_area = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+    float iou = 0.0;
+    float iw = std::min(a[2], b[2]) - std::max(a[0], b[0]) + 1;
+    if (iw > 0) {
+        float ih = std::min(a[3], b[3]) - std::max(a[1], b[1]) + 1;
+        if (ih > 0) {
+            float ua = (a[2] - a[0] + 1) * (a[3] - a[1] + 1) + box_area - iw * ih;
+            iou = iw * ih / ua;
+        }
+    }
+    return 1 - iou;
+}
+
+/**
+ * 稀疏的IoU关联：用均匀网格做空间哈希，只对有重叠的框计算IoU，得到代价小于阈值的二分图，
+ * 再按连通分量拆分，每个分量单独求解指派问题。
+ * 不同分量之间没有可匹配的配对，所以各分量的最优解合起来就是整个稠密矩阵的一个最优解，总代价与稠密求解相同；
+ * 存在代价相等的多个最优解时，选中的匹配可能与稠密求解不同
+ */
+class SparseAssociation {
+public:
+    /**
+     * @param atlbrs 行对应的框，每个框4个float（x1, y1, x2, y2）
+     * @param btlbrs 列对应的框
+     * @param thresh 代价（1 - IoU）不小于thresh的配对不匹配，需要小于1
+     * @param rowsol 每行匹配的列，未匹配为-1
+     * @param colsol 每列匹配的行，未匹配为-1
+     * @param num_threads 大于1时用openmp并行求解各个分量
+     */
+    void solve(const float *atlbrs, int rows, const float *btlbrs, int cols, float thresh,
+               std::vector<int> &rowsol, std::vector<int> &colsol, int num_threads = 1);
+
+    /**
+     * 代价小于thresh的所有配对，按行、列升序
+     */
+    void pairs(const float *atlbrs, int rows, const float *btlbrs, int cols, float thresh,
+               std::vector<std::pair<int, int> > &out);
+
+private:
+    struct Edge {
+        int row;
+        int col;
+        float cost;
+    };
+
+    void build_grid(const float *btlbrs, int cols);
+
+    // 框覆盖的格子范围（闭区间）
+    void cell_range(const float *box, int &cx0, int &cy0, int &cx1, int &cy1) const;
+
+    void find_edges(const float *atlbrs, int rows, const float *btlbrs, float thresh);
+
+    int find_root(int x);
+
+    // 空间哈希，CSR格式：cell_start_[c]..cell_start_[c+1]为格子c中的列
+    float origin_x_ = 0;
+    float origin_y_ = 0;
+    float cell_size_ = 1;
+    int grid_w_ = 0;
+    int grid_h_ = 0;
+    int num_cols_ = 0;
+    std::vector<int> cell_start_;
+    std::vector<int> cell_items_;
+    std::vector<int> col_stamp_;
+    std::vector<int> fill_pos_; // 计数排序的写入位置
+
+    std::vector<Edge> edges_;
+    std::vector<int> parent_;
+
+    // 分量：comp_edges_按分量分组的边，comp_start_为每个分量的起始位置
+    std::vector<int> comp_id_;
+    std::vector<int> comp_start_;
+    std::vector<int> comp_edges_;
+    std::vector<int> local_index_;
+
+    // 每个线程一份求解器和稠密子矩阵
+    struct Worker {
+        LapSolver solver;
+        std::vector<float> cost;
+        std::vector<int> rows;
+        std::vector<int> cols;
+        std::vector<int> rowsol;
+        std::vector<int> colsol;
+    };
+    std::vector<Worker> workers_;
+};
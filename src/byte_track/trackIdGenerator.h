@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * 轨迹id生成器，依次返回 first, first + step, first + 2 * step, ...
+ * 每个跟踪器持有自己的生成器时，id只在本路视频内唯一，多个跟踪器可以并行更新；
+ * K路视频分别使用 first = k + 1、step = K 时，各路id互不相同且与调度顺序无关。
+ * next()是原子操作，多个跟踪器也可以共用一个生成器，此时id全局唯一但分配顺序取决于线程调度
+ */
+class TrackIdGenerator {
+public:
+    explicit TrackIdGenerator(int first = 1, int step = 1) : next_(first), step_(step) {}
+
+    // 拷贝当前计数，副本与原对象之后各自独立计数
+    TrackIdGenerator(const TrackIdGenerator &other)
+            : next_(other.next_.load(std::memory_order_relaxed)), step_(other.step_) {}
+
+    TrackIdGenerator &operator=(const TrackIdGenerator &other) {
+        next_.store(other.next_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        step_ = other.step_;
+        return *this;
+    }
+
+    int next() {
+        return next_.fetch_add(step_, std::memory_order_relaxed);
+    }
+
+    // 重新从first开始计数，调用时不能有其它线程在分配id
+    void reset(int first = 1, int step = 1) {
+        next_.store(first, std::memory_order_relaxed);
+        step_ = step;
+    }
+
+    // 进程内共用的生成器，未指定生成器的旧接口使用它
+    static TrackIdGenerator &global() {
+        static TrackIdGenerator generator;
+        return generator;
+    }
+
+private:
+    std::atomic<int> next_;
+    int step_;
+};
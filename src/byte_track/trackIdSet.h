@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * 轨迹id的开放寻址哈希集合（线性探测），用于轨迹列表的合并、求差。
+ * 每个槽位记录写入时的版本号，reset只增加版本号不清空数组，容量只增不减，每帧复用不分配内存
+ */
+class TrackIdSet {
+public:
+    TrackIdSet() : mask_(0), stamp_(0) {}
+
+    // 清空，并保证插入n个id时装载率不超过1/2
+    void reset(int n) {
+        size_t capacity = 16;
+        while (capacity < (size_t) n * 2) {
+            capacity <<= 1;
+        }
+        if (capacity > keys_.size()) {
+            keys_.assign(capacity, 0);
+            stamps_.assign(capacity, 0);
+            mask_ = capacity - 1;
+            stamp_ = 0;
+        }
+        if (++stamp_ == 0) {
+            // 版本号回绕，旧版本号可能与新的相同，全部清掉
+            stamps_.assign(stamps_.size(), 0);
+            stamp_ = 1;
+        }
+    }
+
+    // 插入id，已经存在时返回false
+    bool insert(int id) {
+        size_t i = hash(id);
+        while (stamps_[i] == stamp_) {
+            if (keys_[i] == id) return false;
+            i = (i + 1) & mask_;
+        }
+        stamps_[i] = stamp_;
+        keys_[i] = id;
+        return true;
+    }
+
+    bool contains(int id) const {
+        size_t i = hash(id);
+        while (stamps_[i] == stamp_) {
+            if (keys_[i] == id) return true;
+            i = (i + 1) & mask_;
+        }
+        return false;
+    }
+
+private:
+    // 乘以黄金分割常数后把高位折叠到低位，连续的id也能均匀分布
+    size_t hash(int id) const {
+        unsigned h = (unsigned) id * 2654435761u;
+        return (size_t) (h ^ (h >> 16)) & mask_;
+    }
+
+    std::vector<int> keys_;
+    std::vector<unsigned> stamps_;
+    size_t mask_;
+    unsigned stamp_;
+};
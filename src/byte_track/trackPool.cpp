@@ -0,0 +1,66 @@
+#include "trackPool.h"
+#include <algorithm>
+
+STrackPool::STrackPool() : size_(0) {
+}
+
+STrackPool::STrackPool(const STrackPool &other) : size_(0) {
+    *this = other;
+}
+
+STrackPool &STrackPool::operator=(const STrackPool &other) {
+    if (this == &other) return *this;
+    slabs_.clear();
+    for (int i = 0; i < other.slabs_.size(); i++) {
+        slabs_.emplace_back(new STrack[slab_size]);
+        std::copy(other.slabs_[i].get(), other.slabs_[i].get() + slab_size, slabs_[i].get());
+    }
+    generations_ = other.generations_;
+    in_use_ = other.in_use_;
+    free_ = other.free_;
+    size_ = other.size_;
+    return *this;
+}
+
+void STrackPool::grow(int n) {
+    while ((int) slabs_.size() * slab_size < n) {
+        slabs_.emplace_back(new STrack[slab_size]);
+    }
+    if (n > size_) {
+        generations_.resize(n, 0);
+        in_use_.resize(n, 1);
+        size_ = n;
+    }
+}
+
+int STrackPool::allocate() {
+    if (!free_.empty()) {
+        int index = free_.back();
+        free_.pop_back();
+        in_use_[index] = 1;
+        return index;
+    }
+    grow(size_ + 1);
+    return size_ - 1;
+}
+
+void STrackPool::release(int index) {
+    in_use_[index] = 0;
+    generations_[index]++;
+    free_.push_back(index);
+}
+
+TrackHandle STrackPool::handle(int index) const {
+    TrackHandle handle;
+    handle.index = index;
+    handle.generation = generations_[index];
+    return handle;
+}
+
+const STrack *STrackPool::get(const TrackHandle &handle) const {
+    if (handle.index < 0 || handle.index >= size_ || !in_use_[handle.index] ||
+        generations_[handle.index] != handle.generation) {
+        return nullptr;
+    }
+    return &(*this)[handle.index];
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "STrack.h"
+
+/**
+ * 轨迹句柄：槽位下标和槽位的版本号。槽位回收时版本号加一，之前发出的句柄随之失效
+ */
+struct TrackHandle {
+    int index;
+    unsigned generation;
+};
+
+/**
+ * STrack的分块对象池，每块slab_size个对象，扩容时只追加新块，已有对象的地址一直不变。
+ * 释放的槽位进入空闲列表，分配时优先复用，池的大小等于历史上同时存在的最大轨迹数，长时间运行不会增长
+ */
+class STrackPool {
+public:
+    static constexpr int slab_shift = 8;
+    static constexpr int slab_size = 1 << slab_shift;
+
+    STrackPool();
+
+    // 拷贝时复制所有对象，跟踪器可以整体拷贝
+    STrackPool(const STrackPool &other);
+
+    STrackPool &operator=(const STrackPool &other);
+
+    STrackPool(STrackPool &&other) = default;
+
+    STrackPool &operator=(STrackPool &&other) = default;
+
+    // 已创建的槽位数（包括空闲的）
+    int size() const { return size_; }
+
+    // 槽位数至少为n，新槽位直接可用，不进入空闲列表（检测框按下标使用时用这种方式）
+    void grow(int n);
+
+    // 取一个空闲槽位，没有空闲槽位时扩容
+    int allocate();
+
+    // 回收槽位，版本号加一
+    void release(int index);
+
+    bool in_use(int index) const { return in_use_[index] != 0; }
+
+    TrackHandle handle(int index) const;
+
+    // 句柄仍然有效时返回轨迹，否则返回nullptr
+    const STrack *get(const TrackHandle &handle) const;
+
+    STrack &operator[](int index) {
+        return slabs_[index >> slab_shift][index & (slab_size - 1)];
+    }
+
+    const STrack &operator[](int index) const {
+        return slabs_[index >> slab_shift][index & (slab_size - 1)];
+    }
+
+private:
+    std::vector<std::unique_ptr<STrack[]> > slabs_;
+    std::vector<unsigned> generations_;
+    std::vector<char> in_use_;
+    std::vector<int> free_;
+    int size_;
+};
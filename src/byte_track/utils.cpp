@@ -1,351 +1,190 @@
 #include "BYTETracker.h"
-#include "lapjv.h"
+#include <algorithm>
 
-std::vector<STrack *> BYTETracker::joint_stracks(std::vector<STrack *> &tlista, std::vector<STrack> &tlistb) {
-    std::map<int, int> exists;
-    std::vector<STrack *> res;
+void BYTETracker::joint_stracks(const TrackList &tlista, const TrackList &tlistb, TrackList &res) {
+    res.clear();
+    res.insert(res.end(), tlista.begin(), tlista.end());
+    id_set.reset(tlista.size() + tlistb.size());
     for (int i = 0; i < tlista.size(); i++) {
-        exists.insert(std::pair<int, int>(tlista[i]->track_id, 1));
-        res.push_back(tlista[i]);
+        id_set.insert(track_pool[tlista[i]].track_id);
     }
     for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(&tlistb[i]);
+        if (id_set.insert(track_pool[tlistb[i]].track_id)) {
+            res.push_back(tlistb[i]);
         }
     }
-    return res;
 }
 
-std::vector<STrack> BYTETracker::joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb) {
-    std::map<int, int> exists;
-    std::vector<STrack> res;
-    for (int i = 0; i < tlista.size(); i++) {
-        exists.insert(std::pair<int, int>(tlista[i].track_id, 1));
-        res.push_back(tlista[i]);
-    }
+void BYTETracker::sub_stracks(const TrackList &tlista, const TrackList &tlistb, TrackList &res) {
+    id_set.reset(tlista.size() + tlistb.size());
     for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(tlistb[i]);
-        }
+        id_set.insert(track_pool[tlistb[i]].track_id);
     }
-    return res;
-}
-
-std::vector<STrack> BYTETracker::sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb) {
-    std::map<int, STrack> stracks;
+    // tlista中重复的id只保留第一个
+    id_slots.clear();
     for (int i = 0; i < tlista.size(); i++) {
-        stracks.insert(std::pair<int, STrack>(tlista[i].track_id, tlista[i]));
-    }
-    for (int i = 0; i < tlistb.size(); i++) {
-        int tid = tlistb[i].track_id;
-        if (stracks.count(tid) != 0) {
-            stracks.erase(tid);
+        int tid = track_pool[tlista[i]].track_id;
+        if (id_set.insert(tid)) {
+            id_slots.push_back(std::pair<int, int>(tid, tlista[i]));
         }
     }
 
-    std::vector<STrack> res;
-    std::map<int, STrack>::iterator it;
-    for (it = stracks.begin(); it != stracks.end(); ++it) {
-        res.push_back(it->second);
+    // 与原来std::map的遍历顺序一致，按track_id升序；id各不相同，直接按(id, 槽位)排序
+    std::sort(id_slots.begin(), id_slots.end());
+    res.clear();
+    for (int i = 0; i < id_slots.size(); i++) {
+        res.push_back(id_slots[i].second);
     }
-
-    return res;
 }
 
-void BYTETracker::remove_duplicate_stracks(std::vector<STrack> &resa, std::vector<STrack> &resb,
-                                           std::vector<STrack> &stracksa,
-                                           std::vector<STrack> &stracksb) {
-    std::vector<std::vector<float> > pdist = iou_distance(stracksa, stracksb);
-    std::vector<std::pair<int, int> > pairs;
-    for (int i = 0; i < pdist.size(); i++) {
-        for (int j = 0; j < pdist[i].size(); j++) {
-            if (pdist[i][j] < 0.15) {
-                pairs.push_back(std::pair<int, int>(i, j));
+void BYTETracker::remove_duplicate_stracks(TrackList &resa, TrackList &resb, const TrackList &stracksa,
+                                           const TrackList &stracksb) {
+    dup_pairs.clear();
+    const int cols = stracksb.size();
+    if ((long long) stracksa.size() * cols <= dense_max_pairs) {
+        iou_distance(track_pool, stracksa, track_pool, stracksb, dists);
+        for (int i = 0; i < stracksa.size() && cols > 0; i++) {
+            for (int j = 0; j < cols; j++) {
+                if (dists[i * cols + j] < 0.15) {
+                    dup_pairs.push_back(std::pair<int, int>(i, j));
+                }
             }
         }
-    }
-
-    std::vector<int> dupa, dupb;
-    for (int i = 0; i < pairs.size(); i++) {
-        int timep = stracksa[pairs[i].first].frame_id - stracksa[pairs[i].first].start_frame;
-        int timeq = stracksb[pairs[i].second].frame_id - stracksb[pairs[i].second].start_frame;
+    } else {
+        gather_tlbrs(track_pool, stracksa, atlbrs);
+        gather_tlbrs(track_pool, stracksb, btlbrs);
+        sparse_association.pairs(atlbrs.data(), stracksa.size(), btlbrs.data(), cols, 0.15f, dup_pairs);
+    }
+
+    // dupa、dupb按下标标记需要去掉的轨迹
+    dupa.assign(stracksa.size(), 0);
+    dupb.assign(stracksb.size(), 0);
+    for (int k = 0; k < dup_pairs.size(); k++) {
+        const STrack &a = track_pool[stracksa[dup_pairs[k].first]];
+        const STrack &b = track_pool[stracksb[dup_pairs[k].second]];
+        int timep = a.frame_id - a.start_frame;
+        int timeq = b.frame_id - b.start_frame;
         if (timep > timeq)
-            dupb.push_back(pairs[i].second);
+            dupb[dup_pairs[k].second] = 1;
         else
-            dupa.push_back(pairs[i].first);
+            dupa[dup_pairs[k].first] = 1;
     }
 
+    resa.clear();
     for (int i = 0; i < stracksa.size(); i++) {
-        std::vector<int>::iterator iter = find(dupa.begin(), dupa.end(), i);
-        if (iter == dupa.end()) {
+        if (!dupa[i]) {
             resa.push_back(stracksa[i]);
         }
     }
 
+    resb.clear();
     for (int i = 0; i < stracksb.size(); i++) {
-        std::vector<int>::iterator iter = find(dupb.begin(), dupb.end(), i);
-        if (iter == dupb.end()) {
+        if (!dupb[i]) {
             resb.push_back(stracksb[i]);
         }
     }
 }
 
-void
-BYTETracker::linear_assignment(std::vector<std::vector<float> > &cost_matrix, int cost_matrix_size,
-                               int cost_matrix_size_size,
-                               float thresh,
-                               std::vector<std::vector<int> > &matches, std::vector<int> &unmatched_a,
-                               std::vector<int> &unmatched_b) {
-    if (cost_matrix.size() == 0) {
-        for (int i = 0; i < cost_matrix_size; i++) {
-            unmatched_a.push_back(i);
-        }
-        for (int i = 0; i < cost_matrix_size_size; i++) {
-            unmatched_b.push_back(i);
-        }
+void BYTETracker::associate(const STrackPool &apool, const TrackList &atracks,
+                            const STrackPool &bpool, const TrackList &btracks, float thresh,
+                            std::vector<std::pair<int, int> > &matches, std::vector<int> &unmatched_a,
+                            std::vector<int> &unmatched_b) {
+    const int rows = atracks.size();
+    const int cols = btracks.size();
+    if ((long long) rows * cols <= dense_max_pairs) {
+        iou_distance(apool, atracks, bpool, btracks, dists);
+        linear_assignment(dists, rows, cols, thresh, matches, unmatched_a, unmatched_b);
         return;
     }
 
-    std::vector<int> rowsol;
-    std::vector<int> colsol;
-    float c = lapjv(cost_matrix, rowsol, colsol, true, thresh);
-    for (int i = 0; i < rowsol.size(); i++) {
+    gather_tlbrs(apool, atracks, atlbrs);
+    gather_tlbrs(bpool, btracks, btlbrs);
+    sparse_association.solve(atlbrs.data(), rows, btlbrs.data(), cols, thresh, rowsol, colsol, num_threads);
+
+    matches.clear();
+    unmatched_a.clear();
+    unmatched_b.clear();
+    for (int i = 0; i < rows; i++) {
         if (rowsol[i] >= 0) {
-            std::vector<int> match;
-            match.push_back(i);
-            match.push_back(rowsol[i]);
-            matches.push_back(match);
+            matches.push_back(std::pair<int, int>(i, rowsol[i]));
         } else {
             unmatched_a.push_back(i);
         }
     }
-
-    for (int i = 0; i < colsol.size(); i++) {
+    for (int i = 0; i < cols; i++) {
         if (colsol[i] < 0) {
             unmatched_b.push_back(i);
         }
     }
 }
 
-std::vector<std::vector<float> >
-BYTETracker::ious(std::vector<std::vector<float> > &atlbrs, std::vector<std::vector<float> > &btlbrs) {
-    std::vector<std::vector<float> > ious;
-    if (atlbrs.size() * btlbrs.size() == 0)
-        return ious;
-
-    ious.resize(atlbrs.size());
-    for (int i = 0; i < ious.size(); i++) {
-        ious[i].resize(btlbrs.size());
+void BYTETracker::gather_tlbrs(const STrackPool &pool, const TrackList &tracks, std::vector<float> &tlbrs) {
+    tlbrs.resize(tracks.size() * 4);
+    for (int i = 0; i < tracks.size(); i++) {
+        const float *tlbr = pool[tracks[i]].tlbr;
+        tlbrs[i * 4 + 0] = tlbr[0];
+        tlbrs[i * 4 + 1] = tlbr[1];
+        tlbrs[i * 4 + 2] = tlbr[2];
+        tlbrs[i * 4 + 3] = tlbr[3];
     }
-
-    //bbox_ious
-    for (int k = 0; k < btlbrs.size(); k++) {
-        std::vector<float> ious_tmp;
-        float box_area = (btlbrs[k][2] - btlbrs[k][0] + 1) * (btlbrs[k][3] - btlbrs[k][1] + 1);
-        for (int n = 0; n < atlbrs.size(); n++) {
-            float iw = std::min(atlbrs[n][2], btlbrs[k][2]) - std::max(atlbrs[n][0], btlbrs[k][0]) + 1;
-            if (iw > 0) {
-                float ih = std::min(atlbrs[n][3], btlbrs[k][3]) - std::max(atlbrs[n][1], btlbrs[k][1]) + 1;
-                if (ih > 0) {
-                    float ua =
-                            (atlbrs[n][2] - atlbrs[n][0] + 1) * (atlbrs[n][3] - atlbrs[n][1] + 1) + box_area - iw * ih;
-                    ious[n][k] = iw * ih / ua;
-                } else {
-                    ious[n][k] = 0.0;
-                }
-            } else {
-                ious[n][k] = 0.0;
-            }
-        }
-    }
-
-    return ious;
 }
 
-std::vector<std::vector<float> >
-BYTETracker::iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks, int &dist_size,
-                          int &dist_size_size) {
-    std::vector<std::vector<float> > cost_matrix;
-    if (atracks.size() * btracks.size() == 0) {
-        dist_size = atracks.size();
-        dist_size_size = btracks.size();
-        return cost_matrix;
-    }
-    std::vector<std::vector<float> > atlbrs, btlbrs;
-    for (int i = 0; i < atracks.size(); i++) {
-        atlbrs.push_back(atracks[i]->tlbr);
-    }
-    for (int i = 0; i < btracks.size(); i++) {
-        btlbrs.push_back(btracks[i].tlbr);
-    }
-
-    dist_size = atracks.size();
-    dist_size_size = btracks.size();
-
-    std::vector<std::vector<float> > _ious = ious(atlbrs, btlbrs);
-
-    for (int i = 0; i < _ious.size(); i++) {
-        std::vector<float> _iou;
-        for (int j = 0; j < _ious[i].size(); j++) {
-            _iou.push_back(1 - _ious[i][j]);
-        }
-        cost_matrix.push_back(_iou);
-    }
-
-    return cost_matrix;
-}
-
-std::vector<std::vector<float> > BYTETracker::iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks) {
-    std::vector<std::vector<float> > atlbrs, btlbrs;
-    for (int i = 0; i < atracks.size(); i++) {
-        atlbrs.push_back(atracks[i].tlbr);
-    }
-    for (int i = 0; i < btracks.size(); i++) {
-        btlbrs.push_back(btracks[i].tlbr);
-    }
-
-    std::vector<std::vector<float> > _ious = ious(atlbrs, btlbrs);
-    std::vector<std::vector<float> > cost_matrix;
-    for (int i = 0; i < _ious.size(); i++) {
-        std::vector<float> _iou;
-        for (int j = 0; j < _ious[i].size(); j++) {
-            _iou.push_back(1 - _ious[i][j]);
+void
+BYTETracker::linear_assignment(const std::vector<float> &cost_matrix, int cost_matrix_size,
+                               int cost_matrix_size_size,
+                               float thresh,
+                               std::vector<std::pair<int, int> > &matches, std::vector<int> &unmatched_a,
+                               std::vector<int> &unmatched_b) {
+    matches.clear();
+    unmatched_a.clear();
+    unmatched_b.clear();
+    if (cost_matrix_size * cost_matrix_size_size == 0) {
+        for (int i = 0; i < cost_matrix_size; i++) {
+            unmatched_a.push_back(i);
         }
-        cost_matrix.push_back(_iou);
-    }
-
-    return cost_matrix;
-}
-
-double
-BYTETracker::lapjv(const std::vector<std::vector<float> > &cost, std::vector<int> &rowsol, std::vector<int> &colsol,
-                   bool extend_cost, float cost_limit, bool return_cost) {
-    std::vector<std::vector<float> > cost_c;
-    cost_c.assign(cost.begin(), cost.end());
-
-    std::vector<std::vector<float> > cost_c_extended;
-
-    int n_rows = cost.size();
-    int n_cols = cost[0].size();
-    rowsol.resize(n_rows);
-    colsol.resize(n_cols);
-
-    int n = 0;
-    if (n_rows == n_cols) {
-        n = n_rows;
-    } else {
-        if (!extend_cost) {
-            std::cout << "set extend_cost=True" << std::endl;
-            system("pause");
-            exit(0);
+        for (int i = 0; i < cost_matrix_size_size; i++) {
+            unmatched_b.push_back(i);
         }
+        return;
     }
 
-    if (extend_cost || cost_limit < LONG_MAX) {
-        n = n_rows + n_cols;
-        cost_c_extended.resize(n);
-        for (int i = 0; i < cost_c_extended.size(); i++)
-            cost_c_extended[i].resize(n);
-
-        if (cost_limit < LONG_MAX) {
-            for (int i = 0; i < cost_c_extended.size(); i++) {
-                for (int j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_limit / 2.0;
-                }
-            }
+    lap_solver.solve(cost_matrix.data(), cost_matrix_size, cost_matrix_size_size, rowsol, colsol, thresh);
+    for (int i = 0; i < rowsol.size(); i++) {
+        if (rowsol[i] >= 0) {
+            matches.push_back(std::pair<int, int>(i, rowsol[i]));
         } else {
-            float cost_max = -1;
-            for (int i = 0; i < cost_c.size(); i++) {
-                for (int j = 0; j < cost_c[i].size(); j++) {
-                    if (cost_c[i][j] > cost_max)
-                        cost_max = cost_c[i][j];
-                }
-            }
-            for (int i = 0; i < cost_c_extended.size(); i++) {
-                for (int j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_max + 1;
-                }
-            }
-        }
-
-        for (int i = n_rows; i < cost_c_extended.size(); i++) {
-            for (int j = n_cols; j < cost_c_extended[i].size(); j++) {
-                cost_c_extended[i][j] = 0;
-            }
-        }
-        for (int i = 0; i < n_rows; i++) {
-            for (int j = 0; j < n_cols; j++) {
-                cost_c_extended[i][j] = cost_c[i][j];
-            }
+            unmatched_a.push_back(i);
         }
-
-        cost_c.clear();
-        cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
     }
 
-    double **cost_ptr;
-    cost_ptr = new double *[sizeof(double *) * n];
-    for (int i = 0; i < n; i++)
-        cost_ptr[i] = new double[sizeof(double) * n];
-
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            cost_ptr[i][j] = cost_c[i][j];
+    for (int i = 0; i < colsol.size(); i++) {
+        if (colsol[i] < 0) {
+            unmatched_b.push_back(i);
         }
     }
+}
 
-    int *x_c = new int[sizeof(int) * n];
-    int *y_c = new int[sizeof(int) * n];
+void BYTETracker::iou_distance(const STrackPool &apool, const TrackList &atracks,
+                               const STrackPool &bpool, const TrackList &btracks,
+                               std::vector<float> &cost_matrix) {
+    const int rows = atracks.size();
+    const int cols = btracks.size();
+    cost_matrix.resize(rows * cols);
 
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
-    if (ret != 0) {
-        std::cout << "Calculate Wrong!" << std::endl;
-        system("pause");
-        exit(0);
+    if (rows * cols == 0) {
+        return;
     }
 
-    double opt = 0.0;
-
-    if (n != n_rows) {
-        for (int i = 0; i < n; i++) {
-            if (x_c[i] >= n_cols)
-                x_c[i] = -1;
-            if (y_c[i] >= n_rows)
-                y_c[i] = -1;
-        }
-        for (int i = 0; i < n_rows; i++) {
-            rowsol[i] = x_c[i];
-        }
-        for (int i = 0; i < n_cols; i++) {
-            colsol[i] = y_c[i];
-        }
-
-        if (return_cost) {
-            for (int i = 0; i < rowsol.size(); i++) {
-                if (rowsol[i] != -1) {
-                    //cout << i << "\t" << rowsol[i] << "\t" << cost_ptr[i][rowsol[i]] << endl;
-                    opt += cost_ptr[i][rowsol[i]];
-                }
-            }
-        }
-    } else if (return_cost) {
-        for (int i = 0; i < rowsol.size(); i++) {
-            opt += cost_ptr[i][rowsol[i]];
-        }
+    // 框整理成SoA后由SIMD核逐行计算
+    aboxes.resize(rows);
+    for (int n = 0; n < rows; n++) {
+        aboxes.set(n, apool[atracks[n]].tlbr);
     }
-
-    for (int i = 0; i < n; i++) {
-        delete[]cost_ptr[i];
+    bboxes.resize(cols);
+    for (int k = 0; k < cols; k++) {
+        bboxes.set(k, bpool[btracks[k]].tlbr);
     }
-    delete[]cost_ptr;
-    delete[]x_c;
-    delete[]y_c;
-
-    return opt;
+    iou_distance_matrix(aboxes, bboxes, cost_matrix.data());
 }
 
 cv::Scalar BYTETracker::get_color(int idx) {
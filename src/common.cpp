@@ -5,6 +5,10 @@
  * @since C++11
 **/
 #include "common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 void draw_objects(cv::Mat &bgr, const std::vector<Object> &objects) {
     for (const auto &obj: objects) {
@@ -34,39 +38,44 @@ void draw_objects(cv::Mat &bgr, const std::vector<Object> &objects) {
 
 MyEncryptedDataReader::MyEncryptedDataReader(const char *filepath, unsigned char _key,
                                              bool is_param)
-        : fp(nullptr), key(_key) {
-    fp = fopen(filepath, "rb");
-    if (!fp) {
-        fprintf(stderr, "open file %s failed\n", filepath);
+        : cipher(&_key, 1) {
+    open(filepath, is_param);
+}
+
+MyEncryptedDataReader::MyEncryptedDataReader(const char *filepath, const unsigned char *key, size_t key_len,
+                                             bool is_param)
+        : cipher(key, key_len) {
+    open(filepath, is_param);
+}
+
+MyEncryptedDataReader::MyEncryptedDataReader(const unsigned char *data, size_t size, const unsigned char *key,
+                                             size_t key_len, bool is_param)
+        : cipher(key, key_len) {
+    attach(data, size, is_param);
+}
+
+void MyEncryptedDataReader::open(const char *filepath, bool is_param) {
+    if (!file.open(filepath)) {
+        return;
     }
+    attach(file.data(), file.size(), is_param);
+}
+
+void MyEncryptedDataReader::attach(const unsigned char *data, size_t size, bool is_param) {
+    data_ptr = data;
+    data_size = data ? size : 0;
     if (is_param) {
-        // 获取文件大小
-        fseek(fp, 0, SEEK_END);
-        long file_size = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-        // 分配内存
+        // param整体解密，多留一个字节作为sscanf需要的结尾0
         memory = new Memory();
-        memory->alloc(file_size);
-        // 读取文件内容
-        size_t nread = fread(memory->buffer_, 1, file_size, fp);
-        if (nread == 0) {
-            fprintf(stderr, "read file %s failed\n", filepath);
-        }
-        // xor decrypt
-        for (size_t i = 0; i < nread; i++) {
-            memory->buffer_[i] ^= key;
-        }
-        // 将文件指针移动到文件开头
-        fseek(fp, 0, SEEK_SET);
+        memory->alloc(data_size + 1);
+        cipher.apply(data_ptr, memory->buffer_, data_size, 0);
+        memory->buffer_[data_size] = 0;
     }
 }
 
 MyEncryptedDataReader::~MyEncryptedDataReader() {
-    if (fp) {
-        fclose(fp);
-        fp = nullptr;
-    }
-    key = 0;
+    file.close();
+    cipher.clear();
     if (memory) {
         delete memory;
         memory = nullptr;
@@ -74,34 +83,208 @@ MyEncryptedDataReader::~MyEncryptedDataReader() {
 }
 
 size_t MyEncryptedDataReader::read(void *buf, size_t size) const {
-    if (!fp) return 0;
-
-    size_t nread = fread(buf, 1, size, fp);
-    if (nread == 0) return 0;
+    if (!data_ptr || offset >= data_size) return 0;
 
-    // xor decrypt
-    unsigned char *p = static_cast<unsigned char *>(buf);
-    for (size_t i = 0; i < nread; i++) {
-        p[i] ^= key;
-    }
+    size_t nread = std::min(size, data_size - offset);
+    // xor decrypt，直接从映射解密到目标缓冲区
+    cipher.apply(data_ptr + offset, static_cast<unsigned char *>(buf), nread, offset);
+    offset += nread;
 
     return nread;
 }
 
-int MyEncryptedDataReader::scan(const char *format, void *p) const {
-    // 通过读取buffer中的数据来实现scan功能
-    if (!fp || !memory) return 0;
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
 
-    size_t fmtlen = strlen(format);
+// 格式中有多个输出或者不支持的转换时交给sscanf
+static const int SCAN_UNSUPPORTED = -2;
 
-    char *format_with_n = new char[fmtlen + 4];
-    sprintf(format_with_n, "%s%%n", format);
+/**
+ * 按scanf的规则解析ncnn用到的格式：%d %f/%e/%g %s %c %[...]，可带宽度和*，格式中的其它字符按字面匹配。
+ * 整个格式匹配成功时nconsumed为读取的字符数，否则为0；不分配内存
+ * @return 赋值的个数，或SCAN_UNSUPPORTED
+ */
+static int scan_text(const char *text, const char *format, void *p, int &nconsumed) {
+    const char *s = text;
+    const char *f = format;
+    int nassigned = 0;
+    nconsumed = 0;
+    while (*f) {
+        if (is_space(*f)) {
+            // 格式中的空白匹配任意个空白
+            while (is_space(*f)) f++;
+            while (is_space(*s)) s++;
+            continue;
+        }
+        if (*f != '%' || f[1] == '%') {
+            if (*f == '%') {
+                f++;
+                while (is_space(*s)) s++;
+            }
+            if (*s != *f) return nassigned;
+            s++;
+            f++;
+            continue;
+        }
+        f++;
+        bool suppress = false;
+        if (*f == '*') {
+            suppress = true;
+            f++;
+        }
+        // DataReader::scan只有一个输出参数
+        if (!suppress && nassigned > 0) return SCAN_UNSUPPORTED;
+        size_t width = 0;
+        while (*f >= '0' && *f <= '9') {
+            width = width * 10 + (*f++ - '0');
+        }
+        const bool has_width = width > 0;
+        if (!has_width) width = (size_t) -1;
+        const char conv = *f++;
+        if (conv != '[' && conv != 'c') {
+            while (is_space(*s)) s++;
+        }
+        switch (conv) {
+            case 'd': {
+                const char *q = s;
+                size_t left = width;
+                bool negative = false;
+                if (left && (*q == '+' || *q == '-')) {
+                    negative = *q == '-';
+                    q++;
+                    left--;
+                }
+                const char *digits = q;
+                unsigned int value = 0;
+                while (left && *q >= '0' && *q <= '9') {
+                    value = value * 10 + (unsigned int) (*q - '0');
+                    q++;
+                    left--;
+                }
+                if (q == digits) return nassigned;
+                if (!suppress) *(int *) p = (int) (negative ? 0u - value : value);
+                s = q;
+                break;
+            }
+            case 'f':
+            case 'e':
+            case 'g':
+            case 'E':
+            case 'G': {
+                char *end = nullptr;
+                float value;
+                if (!has_width) {
+                    value = strtof(s, &end);
+                    if (end == s) return nassigned;
+                    s = end;
+                } else {
+                    // 宽度限制了读取的字符数，拷贝到栈上再转换
+                    char field[64];
+                    size_t n = 0;
+                    while (n < width && n + 1 < sizeof(field) && s[n] && !is_space(s[n])) {
+                        field[n] = s[n];
+                        n++;
+                    }
+                    field[n] = 0;
+                    value = strtof(field, &end);
+                    if (end == field) return nassigned;
+                    s += end - field;
+                }
+                if (!suppress) *(float *) p = value;
+                break;
+            }
+            case 's': {
+                char *out = (char *) p;
+                size_t n = 0;
+                while (n < width && *s && !is_space(*s)) {
+                    if (!suppress) out[n] = *s;
+                    n++;
+                    s++;
+                }
+                if (n == 0) return nassigned;
+                if (!suppress) out[n] = 0;
+                break;
+            }
+            case 'c': {
+                if (!has_width) width = 1;
+                // 与glibc一致，输入不足width时读到结尾为止
+                char *out = (char *) p;
+                size_t n = 0;
+                while (n < width && s[n]) {
+                    if (!suppress) out[n] = s[n];
+                    n++;
+                }
+                if (n == 0) return nassigned;
+                s += n;
+                break;
+            }
+            case '[': {
+                bool in_set[256] = {false};
+                bool negate = false;
+                if (*f == '^') {
+                    negate = true;
+                    f++;
+                }
+                // 紧跟在[或[^后面的]是集合中的字符
+                const char *set = f;
+                while (*f && (*f != ']' || f == set)) {
+                    if (f[1] == '-' && f[2] && f[2] != ']') {
+                        for (int c = (unsigned char) f[0]; c <= (unsigned char) f[2]; c++) {
+                            in_set[c] = true;
+                        }
+                        f += 3;
+                    } else {
+                        in_set[(unsigned char) *f++] = true;
+                    }
+                }
+                if (*f != ']') return SCAN_UNSUPPORTED;
+                f++;
+                char *out = (char *) p;
+                size_t n = 0;
+                while (n < width && *s && in_set[(unsigned char) *s] != negate) {
+                    if (!suppress) out[n] = *s;
+                    n++;
+                    s++;
+                }
+                if (n == 0) return nassigned;
+                if (!suppress) out[n] = 0;
+                break;
+            }
+            default:
+                // 长度修饰符、%n等ncnn用不到的格式
+                return SCAN_UNSUPPORTED;
+        }
+        if (!suppress) nassigned++;
+    }
+    nconsumed = (int) (s - text);
+    return nassigned;
+}
+
+int MyEncryptedDataReader::scan(const char *format, void *p) const {
+    // 通过读取buffer中的数据来实现scan功能
+    if (!memory) return 0;
 
+    const char *text = (const char *) memory->buffer_ + memory->buffer_offset_;
     int nconsumed = 0;
-    int nscan = sscanf((const char *) memory->buffer_ + memory->buffer_offset_, format_with_n, p, &nconsumed);
-    memory->buffer_offset_ += nconsumed;
+    int nscan = scan_text(text, format, p, nconsumed);
+    if (nscan == SCAN_UNSUPPORTED) {
+        // 格式较短时在栈上拼接%n
+        char stack_format[128];
+        std::string heap_format;
+        char *format_with_n = stack_format;
+        size_t fmtlen = strlen(format);
+        if (fmtlen + 3 > sizeof(stack_format)) {
+            heap_format.resize(fmtlen + 3);
+            format_with_n = &heap_format[0];
+        }
+        memcpy(format_with_n, format, fmtlen);
+        memcpy(format_with_n + fmtlen, "%n", 3);
 
-    delete[] format_with_n;
+        nconsumed = 0;
+        nscan = sscanf(text, format_with_n, p, &nconsumed);
+    }
+    memory->buffer_offset_ += nconsumed;
 
     return nconsumed > 0 ? nscan : 0;
 }
@@ -12,6 +12,8 @@
 //#include <android/log.h>
 #include <opencv2/opencv.hpp>
 #include <ncnn/datareader.h>
+#include "model_loader.h"
+#include "xor_cipher.h"
 
 // LOGD实现
 #define TAG "NativeLib"
@@ -62,20 +64,41 @@ public:
     size_t size_ = 0;
 };
 
+/**
+ * 读取异或加密的模型文件。文件整体映射到内存，read时从映射中解密到ncnn的缓冲区，
+ * 拷贝和解密一次完成，不再经过fread的中间缓冲
+ */
 class MyEncryptedDataReader : public ncnn::DataReader {
 public:
     MyEncryptedDataReader(const char *filepath, unsigned char _key, bool is_param = false);
 
+    // 多字节密钥，偏移为i的字节与 key[i % key_len] 异或
+    MyEncryptedDataReader(const char *filepath, const unsigned char *key, size_t key_len, bool is_param = false);
+
+    // 读取内存中的加密数据（如模型包中的一段），data在读取期间必须有效，偏移从data开始计算
+    MyEncryptedDataReader(const unsigned char *data, size_t size, const unsigned char *key, size_t key_len,
+                          bool is_param = false);
+
     ~MyEncryptedDataReader() override;
 
     // 修改为返回实际读取的字节数，与fread一致
     size_t read(void *buf, size_t size) const override;
 
+    // 手工解析ncnn用到的格式（%d %f %255s %15[^,\n ]等），不分配内存；其它格式交给sscanf
     int scan(const char *format, void *p) const override;
 
 private:
-    FILE *fp;
-    unsigned char key;
+    void open(const char *filepath, bool is_param);
+
+    void attach(const unsigned char *data, size_t size, bool is_param);
+
+    MappedFile file;
+    // 加密的数据，指向file的映射或者外部内存
+    const unsigned char *data_ptr = nullptr;
+    size_t data_size = 0;
+    XorKeyStream cipher;
+    // 下一次read在文件中的偏移
+    mutable size_t offset = 0;
     // 创建一个unsigned char类型的数组用来存储读取的数据
     Memory *memory = nullptr;
 };
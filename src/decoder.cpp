@@ -0,0 +1,182 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 10:12
+ * @version V1.0
+ * @since C++11
+**/
+#include <cfloat>
+#include <cmath>
+#include "decoder.h"
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#endif
+// MSVC不定义__SSE2__，x64和/arch:SSE2按_M_X64、_M_IX86_FP判断；/arch:AVX会定义__AVX__
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DECODER_SSE2 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#define DECODER_AVX 1
+#endif
+
+float inverse_sigmoid(float prob) {
+    if (prob <= 0.f) return -FLT_MAX;
+    if (prob >= 1.f) return FLT_MAX;
+    return logf(prob / (1.f - prob));
+}
+
+static inline float sigmoid(float x) {
+    return 1.0f / (1.0f + expf(-x));
+}
+
+// 返回分布的期望
+static float softmax(const float *src, float *dst, int length) {
+    float alpha = -FLT_MAX;
+    for (int c = 0; c < length; c++) {
+        float score = src[c];
+        if (score > alpha) {
+            alpha = score;
+        }
+    }
+
+    float denominator = 0;
+    float dis_sum = 0;
+    for (int i = 0; i < length; ++i) {
+        dst[i] = expf(src[i] - alpha);
+        denominator += dst[i];
+    }
+    for (int i = 0; i < length; ++i) {
+        dst[i] /= denominator;
+        dis_sum += i * dst[i];
+    }
+    return dis_sum;
+}
+
+// 一个格子所有类别logit的最大值，NaN不参与比较（与逐类比较的结果一致）
+// x86的maxps在有NaN时返回第二个操作数，累加值放在第二个操作数上即可跳过NaN；
+// NEON的vmaxq遇到NaN返回NaN，由调用方退回标量比较
+static inline float max_logit(const float *ptr, int n) {
+    int i = 0;
+    float max_value = -FLT_MAX;
+#if DECODER_AVX
+    __m256 _max8 = _mm256_set1_ps(-FLT_MAX);
+    for (; i + 7 < n; i += 8) {
+        _max8 = _mm256_max_ps(_mm256_loadu_ps(ptr + i), _max8);
+    }
+    __m128 _max4 = _mm_max_ps(_mm256_castps256_ps128(_max8), _mm256_extractf128_ps(_max8, 1));
+#elif DECODER_SSE2
+    __m128 _max4 = _mm_set1_ps(-FLT_MAX);
+#endif
+#if DECODER_SSE2
+    for (; i + 3 < n; i += 4) {
+        _max4 = _mm_max_ps(_mm_loadu_ps(ptr + i), _max4);
+    }
+    _max4 = _mm_max_ps(_max4, _mm_movehl_ps(_max4, _max4));
+    _max4 = _mm_max_ss(_max4, _mm_shuffle_ps(_max4, _max4, 1));
+    max_value = _mm_cvtss_f32(_max4);
+#elif __ARM_NEON
+    float32x4_t _max4 = vdupq_n_f32(-FLT_MAX);
+    for (; i + 3 < n; i += 4) {
+        _max4 = vmaxq_f32(_max4, vld1q_f32(ptr + i));
+    }
+    float32x2_t _max2 = vmax_f32(vget_low_f32(_max4), vget_high_f32(_max4));
+    _max2 = vpmax_f32(_max2, _max2);
+    max_value = vget_lane_f32(_max2, 0);
+#endif
+    for (; i < n; i++) {
+        max_value = ptr[i] > max_value ? ptr[i] : max_value;
+    }
+    return max_value;
+}
+
+static inline float max_logit_scalar(const float *ptr, int n) {
+    float max_value = -FLT_MAX;
+    for (int i = 0; i < n; i++) {
+        max_value = ptr[i] > max_value ? ptr[i] : max_value;
+    }
+    return max_value;
+}
+
+void decode_proposals(int stride, const ncnn::Mat &feat_blob, float logit_threshold,
+                      std::vector<Object> &objects, int reg_max,
+                      const int *class_ids, int num_class_ids) {
+    float dst[DECODE_MAX_REG_MAX];
+    const int num_w = feat_blob.w;
+    const int num_grid_y = feat_blob.c;
+    const int num_grid_x = feat_blob.h;
+
+    const int num_class = num_w - 4 * reg_max;
+    if (reg_max < 1 || reg_max > DECODE_MAX_REG_MAX || num_class <= 0) {
+        return;
+    }
+
+    // 超出模型类别数的id直接忽略
+    while (class_ids && num_class_ids > 0 && class_ids[num_class_ids - 1] >= num_class) {
+        num_class_ids--;
+    }
+    if (class_ids && num_class_ids == 0) {
+        return;
+    }
+
+    for (int i = 0; i < num_grid_y; i++) {
+        const float *row_ptr = feat_blob.channel(i);
+        for (int j = 0; j < num_grid_x; j++) {
+            const float *matat = row_ptr + j * num_w;
+            const float *scores = matat + 4 * reg_max;
+
+            int class_index = 0;
+            float max_score = -FLT_MAX;
+            if (class_ids) {
+                // 只在需要的类别里找最大值，其他类别不会成为候选框
+                for (int k = 0; k < num_class_ids; k++) {
+                    if (scores[class_ids[k]] > max_score) {
+                        class_index = class_ids[k];
+                        max_score = scores[class_index];
+                    }
+                }
+                if (!(max_score >= logit_threshold)) {
+                    continue;
+                }
+            } else {
+                max_score = max_logit(scores, num_class);
+                // NEON的最大值可能是NaN，退回标量比较；全部为NaN时是-FLT_MAX，写成!(>=)也不会放过NaN
+                if (max_score != max_score) {
+                    max_score = max_logit_scalar(scores, num_class);
+                }
+                if (!(max_score >= logit_threshold)) {
+                    continue;
+                }
+
+                // sigmoid单调，logit最大的类别就是概率最大的类别
+                while (class_index < num_class && scores[class_index] != max_score) {
+                    class_index++;
+                }
+                // 找不到说明max_score不是这一行的值，不能越界继续找
+                if (class_index == num_class) {
+                    continue;
+                }
+            }
+
+            float x0 = j + 0.5f - softmax(matat, dst, reg_max);
+            float y0 = i + 0.5f - softmax(matat + reg_max, dst, reg_max);
+            float x1 = j + 0.5f + softmax(matat + 2 * reg_max, dst, reg_max);
+            float y1 = i + 0.5f + softmax(matat + 3 * reg_max, dst, reg_max);
+
+            x0 *= stride;
+            y0 *= stride;
+            x1 *= stride;
+            y1 *= stride;
+
+            Object obj;
+            obj.rect.x = x0;
+            obj.rect.y = y0;
+            obj.rect.width = x1 - x0;
+            obj.rect.height = y1 - y0;
+            obj.label = class_index;
+            obj.prob = sigmoid(max_score);
+            objects.push_back(obj);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 10:12
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_DECODER_H
+#define ZHANGCHAO_DECODER_H
+
+#include <vector>
+#include <ncnn/mat.h>
+#include "common.h"
+
+// DFL分布长度的上限，decode_proposals在栈上展开每条边的分布
+static const int DECODE_MAX_REG_MAX = 32;
+
+/**
+ * 把概率阈值换算到logit空间：sigmoid(x) >= prob  <=>  x >= log(prob / (1 - prob))
+ * @param prob 概率阈值
+ * @return logit阈值，prob<=0返回-FLT_MAX，prob>=1返回FLT_MAX
+ */
+float inverse_sigmoid(float prob);
+
+/**
+ * 阈值优先的检测头解码
+ * 先用SIMD在原始logit上求每个格子的最大类别分数，与logit阈值比较，
+ * 只有通过的格子才计算sigmoid和DFL，结果与逐类sigmoid的做法一致
+ * @param stride 当前检测头的下采样倍数
+ * @param feat_blob 检测头输出，c=grid_y，h=grid_x，w=4*reg_max+num_class
+ * @param logit_threshold inverse_sigmoid(prob_threshold)
+ * @param objects 解码结果，追加到末尾，坐标为网络输入尺度
+ * @param reg_max DFL的分布长度，1..DECODE_MAX_REG_MAX，超出范围或w <= 4*reg_max时不解码
+ * @param class_ids 只解码这些类别（升序），nullptr解码全部类别
+ * @param num_class_ids class_ids的个数
+ */
+void decode_proposals(int stride, const ncnn::Mat &feat_blob, float logit_threshold,
+                      std::vector<Object> &objects, int reg_max = 16,
+                      const int *class_ids = nullptr, int num_class_ids = 0);
+
+#endif //ZHANGCHAO_DECODER_H
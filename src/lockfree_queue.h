@@ -0,0 +1,163 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 09:30
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_LOCKFREE_QUEUE_H
+#define ZHANGCHAO_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * 有界多生产者多消费者无锁队列（Dmitry Vyukov的环形队列），容量向上取整到2的幂
+ */
+template<typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue &) = delete;
+
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    bool try_push(const T &value) {
+        Cell *cell;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false; // 满
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &value) {
+        Cell *cell;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t) seq - (intptr_t) (pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false; // 空
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        // 移出数据，槽位不再持有引用，避免cv::Mat等被一直占住直到槽位被覆盖
+        value = std::move(cell->data);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+/**
+ * 把乱序完成的任务按序号恢复顺序，序号从0开始连续分配
+ * 同时未完成的任务不超过window个，用index % window做槽位不会冲突
+ */
+template<typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(size_t window) : items_(window, nullptr), indices_(window, -1) {}
+
+    /**
+     * 放入序号为index的任务，再按顺序对所有已经连续的任务调用emit
+     */
+    template<typename Emit>
+    void put(int64_t index, T *item, Emit emit) {
+        const size_t window = items_.size();
+        items_[index % window] = item;
+        indices_[index % window] = index;
+        for (;;) {
+            const size_t slot = expected_ % window;
+            if (!items_[slot] || indices_[slot] != expected_) {
+                break;
+            }
+            T *ready = items_[slot];
+            items_[slot] = nullptr;
+            expected_++;
+            emit(ready);
+        }
+    }
+
+    // 下一个要输出的序号
+    int64_t expected() const { return expected_; }
+
+private:
+    std::vector<T *> items_;
+    std::vector<int64_t> indices_;
+    int64_t expected_ = 0;
+};
+
+/**
+ * 等待时先自旋再让出cpu，最后短暂休眠，避免空闲的流水线线程占满核心
+ */
+class Backoff {
+public:
+    void pause() {
+        if (count_ < 64) {
+            count_++;
+        } else if (count_ < 128) {
+            count_++;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    void reset() { count_ = 0; }
+
+private:
+    int count_ = 0;
+};
+
+#endif //ZHANGCHAO_LOCKFREE_QUEUE_H
@@ -16,8 +16,9 @@ MMCls::MMCls() {
 }
 
 bool MMCls::load_model(const char *param_path, const char *bin_path, int input_size, bool use_gpu,
-                       unsigned char key1, unsigned char key2) {
+                       unsigned char key1, unsigned char key2, bool use_mmap) {
     net_.clear();
+    model_file_.close();
     blob_pool_allocator_.clear();
     workspace_pool_allocator_.clear();
 
@@ -47,6 +48,14 @@ bool MMCls::load_model(const char *param_path, const char *bin_path, int input_s
 //	}
 //	LOGD("load_model %s ret=%d", bin_path, ret);
 
+    if (use_mmap) {
+        if (load_model_mmap(net_, param_path, bin_path, key1, key2, model_file_) != 0) {
+            return false;
+        }
+        this->input_size_ = input_size;
+        return true;
+    }
+
     MyEncryptedDataReader param_reader(param_path, key1, true);
     auto ret = net_.load_param(param_reader);
     if (ret != 0) {
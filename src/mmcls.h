@@ -12,6 +12,7 @@
 #include <ncnn/net.h>
 #include <ncnn/layer.h>
 #include "common.h"
+#include "model_loader.h"
 
 class MMCls {
 public:
@@ -19,14 +20,19 @@ public:
 
     ~MMCls();
 
+    /**
+     * @param use_mmap 映射模型文件加载，未加密的权重直接引用映射的页，多个进程共享page cache
+     */
     bool load_model(const char *param_path, const char *bin_path, int input_size, bool use_gpu,
-                    unsigned char key1 = 0, unsigned char key2 = 0);
+                    unsigned char key1 = 0, unsigned char key2 = 0, bool use_mmap = false);
 
     bool detect(const cv::Mat &rgb, std::vector<ClassifyOutput> &result);
 
     bool detect(const cv::Mat &rgb, ClassifyOutput &result);
 
 private:
+    // 映射的bin文件，net_引用其中的权重，要在net_之后析构
+    MappedFile model_file_;
     ncnn::Net net_;
     const int resize_size_{256};
     int input_size_{};
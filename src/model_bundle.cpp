@@ -0,0 +1,399 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 17:20
+ * @version V1.0
+ * @since C++11
+**/
+#include "model_bundle.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "common.h"
+#include "decoder.h"
+#include "xor_cipher.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// slicing-by-8，每次处理8字节
+static const uint32_t (&crc32_tables())[8][256] {
+    static uint32_t tables[8][256];
+    static bool initialized = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            tables[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int t = 1; t < 8; t++) {
+                tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xff];
+            }
+        }
+        return true;
+    }();
+    (void) initialized;
+    return tables;
+}
+
+uint32_t bundle_crc32(const void *data, size_t size, uint32_t crc) {
+    const uint32_t (&t)[8][256] = crc32_tables();
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char> &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((unsigned char) (v >> (8 * i)));
+    }
+}
+
+static void put_string(std::vector<unsigned char> &out, const std::string &s) {
+    put_u32(out, (uint32_t) s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// 顺序读取元数据，越界后所有读取都失败
+struct MetadataCursor {
+    const unsigned char *p;
+    const unsigned char *end;
+    bool ok = true;
+
+    uint32_t u32() {
+        if (end - p < 4) {
+            ok = false;
+            return 0;
+        }
+        uint32_t v = (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+        p += 4;
+        return v;
+    }
+
+    std::string string() {
+        uint32_t n = u32();
+        if (!ok || (size_t) (end - p) < n) {
+            ok = false;
+            return std::string();
+        }
+        std::string s((const char *) p, n);
+        p += n;
+        return s;
+    }
+};
+
+// 版本2在末尾加了crc32
+static const uint32_t METADATA_VERSION = 2;
+
+bool check_metadata(const ModelMetadata &metadata) {
+    if (metadata.input_width <= 0 || metadata.input_height <= 0 || metadata.output_names.empty() ||
+        metadata.reg_max < 1 || metadata.reg_max > DECODE_MAX_REG_MAX ||
+        metadata.strides.size() != metadata.output_names.size()) {
+        return false;
+    }
+    for (int stride: metadata.strides) {
+        if (stride <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void encode_metadata(const ModelMetadata &metadata, std::vector<unsigned char> &out) {
+    out.clear();
+    put_u32(out, METADATA_VERSION);
+    put_string(out, metadata.task);
+    put_u32(out, (uint32_t) metadata.input_width);
+    put_u32(out, (uint32_t) metadata.input_height);
+    put_u32(out, (uint32_t) metadata.reg_max);
+    put_string(out, metadata.input_name);
+    put_u32(out, (uint32_t) metadata.output_names.size());
+    for (size_t i = 0; i < metadata.output_names.size(); i++) {
+        put_string(out, metadata.output_names[i]);
+        put_u32(out, (uint32_t) (i < metadata.strides.size() ? metadata.strides[i] : 0));
+    }
+    put_u32(out, (uint32_t) metadata.class_names.size());
+    for (const auto &name: metadata.class_names) {
+        put_string(out, name);
+    }
+    put_u32(out, bundle_crc32(out.data(), out.size()));
+}
+
+bool decode_metadata(const unsigned char *data, size_t size, ModelMetadata &metadata) {
+    if (size < 8) {
+        return false;
+    }
+    // 先校验明文的crc32，数据损坏或密钥错误时不解析
+    MetadataCursor crc_cur{data + size - 4, data + size};
+    if (crc_cur.u32() != bundle_crc32(data, size - 4)) {
+        return false;
+    }
+    MetadataCursor cur{data, data + size - 4};
+    if (cur.u32() != METADATA_VERSION) {
+        return false;
+    }
+    ModelMetadata m;
+    m.task = cur.string();
+    m.input_width = (int) cur.u32();
+    m.input_height = (int) cur.u32();
+    m.reg_max = (int) cur.u32();
+    m.input_name = cur.string();
+    uint32_t num_outputs = cur.u32();
+    m.output_names.clear();
+    m.strides.clear();
+    for (uint32_t i = 0; i < num_outputs && cur.ok; i++) {
+        m.output_names.push_back(cur.string());
+        m.strides.push_back((int) cur.u32());
+    }
+    uint32_t num_classes = cur.u32();
+    for (uint32_t i = 0; i < num_classes && cur.ok; i++) {
+        m.class_names.push_back(cur.string());
+    }
+    if (!cur.ok || cur.p != cur.end || !check_metadata(m)) {
+        return false;
+    }
+    metadata = std::move(m);
+    return true;
+}
+
+static size_t align_up(size_t v) {
+    return (v + BUNDLE_ALIGN - 1) / BUNDLE_ALIGN * BUNDLE_ALIGN;
+}
+
+static bool write_padding(FILE *fp, size_t from, size_t to) {
+    static const unsigned char zeros[BUNDLE_ALIGN] = {0};
+    return to <= from || fwrite(zeros, 1, to - from, fp) == to - from;
+}
+
+int write_model_bundle(const char *path, const std::vector<BundleSectionInput> &sections,
+                       const unsigned char *key, size_t key_len) {
+    XorKeyStream cipher(key, key_len);
+    for (const auto &input: sections) {
+        if (input.encrypt && cipher.empty()) {
+            fprintf(stderr, "bundle section %u needs a non-zero key\n", input.type);
+            return -1;
+        }
+    }
+
+    const std::string tmp_path = std::string(path) + ".tmp";
+    FILE *fp = fopen(tmp_path.c_str(), "wb");
+    if (!fp) {
+        fprintf(stderr, "open file %s failed\n", tmp_path.c_str());
+        return -1;
+    }
+
+    BundleHeader header;
+    memset(&header, 0, sizeof(header));
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    // 按段写出数据，加密的段分块加密后写出
+    std::vector<BundleSection> table;
+    std::vector<unsigned char> chunk;
+    size_t pos = sizeof(header);
+    for (const auto &input: sections) {
+        if (!ok) break;
+        BundleSection section;
+        memset(&section, 0, sizeof(section));
+        section.type = input.type;
+        section.flags = input.encrypt ? BUNDLE_SECTION_ENCRYPTED : 0;
+        section.offset = align_up(pos);
+        section.size = input.size;
+        ok = write_padding(fp, pos, section.offset);
+
+        uint32_t crc = 0;
+        for (size_t done = 0; ok && done < input.size;) {
+            size_t n = std::min<size_t>(input.size - done, 1 << 20);
+            const unsigned char *src = input.data + done;
+            if (input.encrypt) {
+                chunk.resize(n);
+                cipher.apply(src, chunk.data(), n, done);
+                src = chunk.data();
+            }
+            crc = bundle_crc32(src, n, crc);
+            ok = fwrite(src, 1, n, fp) == n;
+            done += n;
+        }
+        section.crc32 = crc;
+        table.push_back(section);
+        pos = section.offset + section.size;
+    }
+
+    memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = BUNDLE_VERSION;
+    header.section_count = (uint32_t) table.size();
+    header.section_table_offset = align_up(pos);
+    header.file_size = header.section_table_offset + table.size() * sizeof(BundleSection);
+    header.table_crc32 = bundle_crc32(table.data(), table.size() * sizeof(BundleSection));
+    header.header_crc32 = bundle_crc32(&header, sizeof(header));
+
+    ok = ok && write_padding(fp, pos, header.section_table_offset);
+    ok = ok && fwrite(table.data(), sizeof(BundleSection), table.size(), fp) == table.size();
+    ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fflush(fp) == 0;
+    // 替换之前确保数据已经落盘，掉电后不会留下不完整的模型包
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(fp)) == 0;
+#else
+    ok = ok && fsync(fileno(fp)) == 0;
+#endif
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "write file %s failed\n", tmp_path.c_str());
+        remove(tmp_path.c_str());
+        return -1;
+    }
+
+#ifdef _WIN32
+    ok = MoveFileExA(tmp_path.c_str(), path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = rename(tmp_path.c_str(), path) == 0;
+#endif
+    if (!ok) {
+        fprintf(stderr, "rename %s to %s failed\n", tmp_path.c_str(), path);
+        remove(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+bool ModelBundle::open(const char *path, bool verify) {
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+
+    BundleHeader header;
+    bool ok = file_.size() >= sizeof(header);
+    if (ok) {
+        memcpy(&header, file_.data(), sizeof(header));
+        uint32_t header_crc = header.header_crc32;
+        header.header_crc32 = 0;
+        ok = memcmp(header.magic, BUNDLE_MAGIC, sizeof(header.magic)) == 0 && header.version == BUNDLE_VERSION &&
+             bundle_crc32(&header, sizeof(header)) == header_crc && header.file_size == file_.size() &&
+             header.section_table_offset <= file_.size() &&
+             (file_.size() - header.section_table_offset) / sizeof(BundleSection) >= header.section_count;
+    }
+    if (!ok) {
+        fprintf(stderr, "bundle %s has a bad header\n", path);
+        close();
+        return false;
+    }
+
+    const unsigned char *table = file_.data() + header.section_table_offset;
+    const size_t table_size = header.section_count * sizeof(BundleSection);
+    if (bundle_crc32(table, table_size) != header.table_crc32) {
+        fprintf(stderr, "bundle %s has a bad section table\n", path);
+        close();
+        return false;
+    }
+    sections_.resize(header.section_count);
+    memcpy(sections_.data(), table, table_size);
+
+    for (const auto &section: sections_) {
+        ok = section.offset % BUNDLE_ALIGN == 0 && section.offset <= header.section_table_offset &&
+             section.size <= header.section_table_offset - section.offset;
+        if (ok && verify) {
+            ok = bundle_crc32(section_data(section), section.size) == section.crc32;
+        }
+        if (!ok) {
+            fprintf(stderr, "bundle %s section %u is corrupted\n", path, section.type);
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ModelBundle::close() {
+    file_.close();
+    sections_.clear();
+}
+
+const BundleSection *ModelBundle::find(uint32_t type) const {
+    for (const auto &section: sections_) {
+        if (section.type == type) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+int ModelBundle::load_net(ncnn::Net &net, const unsigned char *key, size_t key_len) const {
+    const BundleSection *param = find(BUNDLE_SECTION_PARAM);
+    const BundleSection *bin = find(BUNDLE_SECTION_BIN);
+    if (!param || !bin) {
+        fprintf(stderr, "bundle has no param or bin section\n");
+        return -1;
+    }
+    const bool has_key = !XorKeyStream(key, key_len).empty();
+    if (((param->flags | bin->flags) & BUNDLE_SECTION_ENCRYPTED) && !has_key) {
+        fprintf(stderr, "bundle is encrypted but no key is given\n");
+        return -1;
+    }
+
+    int ret;
+    if (param->flags & BUNDLE_SECTION_ENCRYPTED) {
+        MyEncryptedDataReader param_reader(section_data(*param), param->size, key, key_len, true);
+        ret = net.load_param(param_reader);
+    } else {
+        // 打包时param末尾带0，直接在映射上解析
+        const char *text = (const char *) section_data(*param);
+        ret = param->size > 0 && text[param->size - 1] == 0 ? net.load_param_mem(text) : -1;
+    }
+    if (ret != 0) {
+        fprintf(stderr, "load bundle param failed\n");
+        return -1;
+    }
+
+    if (bin->flags & BUNDLE_SECTION_ENCRYPTED) {
+        MyEncryptedDataReader model_reader(section_data(*bin), bin->size, key, key_len);
+        if (net.load_model(model_reader) != 0) {
+            fprintf(stderr, "load bundle model failed\n");
+            return -1;
+        }
+        return 0;
+    }
+    // 段的起始偏移按64字节对齐，满足ncnn的对齐要求；读取不超出段的长度
+    BoundedMemoryReader model_reader(section_data(*bin), bin->size);
+    if (net.load_model(model_reader) != 0) {
+        fprintf(stderr, "load bundle model failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+bool ModelBundle::read_metadata(ModelMetadata &metadata, const unsigned char *key, size_t key_len) const {
+    const BundleSection *section = find(BUNDLE_SECTION_METADATA);
+    if (!section) {
+        return false;
+    }
+    if (!(section->flags & BUNDLE_SECTION_ENCRYPTED)) {
+        return decode_metadata(section_data(*section), section->size, metadata);
+    }
+    XorKeyStream cipher(key, key_len);
+    if (cipher.empty()) {
+        fprintf(stderr, "bundle metadata is encrypted but no key is given\n");
+        return false;
+    }
+    std::vector<unsigned char> plain(section->size);
+    cipher.apply(section_data(*section), plain.data(), plain.size(), 0);
+    return decode_metadata(plain.data(), plain.size(), metadata);
+}
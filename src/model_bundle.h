@@ -0,0 +1,137 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 17:20
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_MODEL_BUNDLE_H
+#define ZHANGCHAO_MODEL_BUNDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ncnn/net.h>
+#include "model_loader.h"
+
+/**
+ * 模型包：param、bin和元数据放在一个文件里，整体mmap后直接使用。
+ * 布局（小端）：BundleHeader | 各段数据（起始偏移按64字节对齐）| BundleSection表
+ * 每段单独记录crc32，可以单独加密；加密方式与MyEncryptedDataReader相同，偏移从段的起始处计算。
+ * 打包时先写临时文件再rename，替换是原子的，已经映射旧文件的进程不受影响
+ */
+
+static const char BUNDLE_MAGIC[8] = {'N', 'C', 'N', 'N', 'B', 'D', 'L', 0};
+static const uint32_t BUNDLE_VERSION = 1;
+static const size_t BUNDLE_ALIGN = 64;
+
+enum BundleSectionType : uint32_t {
+    BUNDLE_SECTION_PARAM = 1,     // param文本，以0结尾，可以直接load_param_mem
+    BUNDLE_SECTION_BIN = 2,       // 权重，未加密时ncnn直接引用映射的页
+    BUNDLE_SECTION_METADATA = 3,  // encode_metadata的结果
+};
+
+enum BundleSectionFlag : uint32_t {
+    BUNDLE_SECTION_ENCRYPTED = 1,
+};
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t section_table_offset;
+    uint64_t file_size;
+    uint32_t table_crc32;   // 段表的crc32
+    uint32_t header_crc32;  // 本字段为0时整个头的crc32
+    uint8_t reserved[24];
+};
+
+struct BundleSection {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t crc32;         // 文件中存储的字节（加密后）的crc32，不需要密钥就能校验
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BundleHeader) == 64, "BundleHeader layout");
+static_assert(sizeof(BundleSection) == 32, "BundleSection layout");
+
+/**
+ * 检测模型的元数据，替代metadata.yaml，以二进制段保存
+ */
+struct ModelMetadata {
+    std::string task = "detect";
+    int input_width = 640;
+    int input_height = 640;
+    int reg_max = 16;
+    std::string input_name = "in0";
+    std::vector<std::string> output_names = {"out0", "out1", "out2"};
+    std::vector<int> strides = {8, 16, 32};  // 与output_names一一对应
+    std::vector<std::string> class_names;
+};
+
+/**
+ * 元数据能否交给解码器使用：输入尺寸为正，至少一个输出，reg_max在1..DECODE_MAX_REG_MAX，
+ * strides与output_names一一对应且都为正
+ */
+bool check_metadata(const ModelMetadata &metadata);
+
+// 末尾带明文的crc32，加密的元数据用错误的密钥解密后校验不通过
+void encode_metadata(const ModelMetadata &metadata, std::vector<unsigned char> &out);
+
+// 数据不完整、版本不符、crc32不符或check_metadata不通过时返回false
+bool decode_metadata(const unsigned char *data, size_t size, ModelMetadata &metadata);
+
+// 标准crc32（多项式0xEDB88320），可以分段累计
+uint32_t bundle_crc32(const void *data, size_t size, uint32_t crc = 0);
+
+struct BundleSectionInput {
+    uint32_t type;
+    const unsigned char *data;
+    size_t size;
+    bool encrypt;
+};
+
+/**
+ * 写出模型包，先写到path.tmp，完成后替换path
+ * @return 0成功，-1失败
+ */
+int write_model_bundle(const char *path, const std::vector<BundleSectionInput> &sections,
+                       const unsigned char *key = nullptr, size_t key_len = 0);
+
+class ModelBundle {
+public:
+    /**
+     * 映射并检查头和段表
+     * @param verify 同时校验每段数据的crc32
+     */
+    bool open(const char *path, bool verify = true);
+
+    void close();
+
+    bool is_open() const { return file_.is_open(); }
+
+    // 没有该类型的段时返回nullptr
+    const BundleSection *find(uint32_t type) const;
+
+    const unsigned char *section_data(const BundleSection &section) const { return file_.data() + section.offset; }
+
+    const std::vector<BundleSection> &sections() const { return sections_; }
+
+    /**
+     * 加载param和bin。未加密的bin直接引用映射的页，网络使用期间bundle必须保持打开
+     * @return 0成功，-1失败
+     */
+    int load_net(ncnn::Net &net, const unsigned char *key = nullptr, size_t key_len = 0) const;
+
+    bool read_metadata(ModelMetadata &metadata, const unsigned char *key = nullptr, size_t key_len = 0) const;
+
+private:
+    MappedFile file_;
+    std::vector<BundleSection> sections_;
+};
+
+#endif //ZHANGCHAO_MODEL_BUNDLE_H
@@ -0,0 +1,167 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 14:10
+ * @version V1.0
+ * @since C++11
+**/
+#include "model_loader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "common.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char *filepath) {
+    close();
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "open file %s failed\n", filepath);
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        fprintf(stderr, "mmap file %s failed\n", filepath);
+        return false;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        fprintf(stderr, "mmap file %s failed\n", filepath);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const unsigned char *>(data);
+    size_ = (size_t) file_size.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        CloseHandle((HANDLE) mapping_);
+        CloseHandle((HANDLE) file_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    file_ = nullptr;
+    mapping_ = nullptr;
+}
+#else
+bool MappedFile::open(const char *filepath) {
+    close();
+    int fd = ::open(filepath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open file %s failed\n", filepath);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // 映射建立后文件描述符不再需要
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "mmap file %s failed\n", filepath);
+        return false;
+    }
+    // 加载时顺序读取整个文件，提前预读
+    madvise(data, (size_t) st.st_size, MADV_WILLNEED);
+    data_ = static_cast<const unsigned char *>(data);
+    size_ = (size_t) st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap((void *) data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+#endif
+
+size_t BoundedMemoryReader::read(void *buf, size_t size) const {
+    const size_t n = std::min(size, size_ - offset_);
+    memcpy(buf, data_ + offset_, n);
+    offset_ += n;
+    return n;
+}
+
+size_t BoundedMemoryReader::reference(size_t size, const void **buf) const {
+    if (size > size_ - offset_) {
+        return 0;
+    }
+    *buf = data_ + offset_;
+    offset_ += size;
+    return size;
+}
+
+int load_model_mmap(ncnn::Net &net, const char *param_path, const char *bin_path, unsigned char param_key,
+                    unsigned char bin_key, MappedFile &bin_file) {
+    bin_file.close();
+
+    if (param_key == 0) {
+        // load_param_mem需要以0结尾的字符串，param文件很小，拷贝一份
+        MappedFile param_file;
+        if (!param_file.open(param_path)) {
+            return -1;
+        }
+        std::string text((const char *) param_file.data(), param_file.size());
+        if (net.load_param_mem(text.c_str()) != 0) {
+            fprintf(stderr, "load param %s failed\n", param_path);
+            return -1;
+        }
+    } else {
+        MyEncryptedDataReader param_reader(param_path, param_key, true);
+        if (net.load_param(param_reader) != 0) {
+            fprintf(stderr, "load param %s failed\n", param_path);
+            return -1;
+        }
+    }
+
+    if (bin_key != 0) {
+        MyEncryptedDataReader model_reader(bin_path, bin_key);
+        if (net.load_model(model_reader) != 0) {
+            fprintf(stderr, "load model %s failed\n", bin_path);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!bin_file.open(bin_path)) {
+        return -1;
+    }
+    // 映射的起始地址按页对齐，满足ncnn的32位对齐要求；读取不超出文件长度，截断的文件在这里失败
+    BoundedMemoryReader model_reader(bin_file.data(), bin_file.size());
+    if (net.load_model(model_reader) != 0) {
+        fprintf(stderr, "load model %s failed\n", bin_path);
+        bin_file.close();
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 14:10
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_MODEL_LOADER_H
+#define ZHANGCHAO_MODEL_LOADER_H
+
+#include <cstddef>
+#include <ncnn/datareader.h>
+#include <ncnn/net.h>
+
+/**
+ * 只读映射整个文件，映射的页由系统page cache提供，同一台机器上映射同一文件的进程共享物理内存
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    // 成功返回true，已打开的文件先关闭
+    bool open(const char *filepath);
+
+    void close();
+
+    const unsigned char *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool is_open() const { return data_ != nullptr; }
+
+private:
+    const unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#endif
+};
+
+/**
+ * 读取一段已知长度的内存中的模型权重，reference直接返回内存中的地址，权重不拷贝。
+ * 与ncnn的DataReaderFromMemory不同，读到末尾后返回0，截断的bin文件加载失败而不是越界读取
+ */
+class BoundedMemoryReader : public ncnn::DataReader {
+public:
+    BoundedMemoryReader(const unsigned char *data, size_t size) : data_(data), size_(size) {}
+
+    size_t read(void *buf, size_t size) const override;
+
+    // 剩余不足size字节时返回0
+    size_t reference(size_t size, const void **buf) const override;
+
+    // 已经读取的字节数
+    size_t offset() const { return offset_; }
+
+private:
+    const unsigned char *data_;
+    size_t size_;
+    mutable size_t offset_ = 0;
+};
+
+/**
+ * 以mmap方式加载ncnn模型。
+ * bin未加密时，ncnn直接引用映射的页作为权重（需要重排的层仍会拷贝），进程之间共享，
+ * 网络使用期间bin_file必须保持打开；加密的文件无法原地引用，解密后加载，加载完bin_file会被关闭。
+ * 读取不超出映射的范围，bin比param描述的权重短时返回-1
+ * @return 0成功，-1失败
+ */
+int load_model_mmap(ncnn::Net &net, const char *param_path, const char *bin_path, unsigned char param_key,
+                    unsigned char bin_key, MappedFile &bin_file);
+
+#endif //ZHANGCHAO_MODEL_LOADER_H
@@ -0,0 +1,96 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 14:05
+ * @version V1.0
+ * @since C++11
+**/
+#include <algorithm>
+#include "nms.h"
+
+void NmsEngine::run(const std::vector<Object> &proposals, float iou_threshold, std::vector<int> &keep) {
+    keep.clear();
+    const int n = (int) proposals.size();
+    if (n == 0) return;
+
+    x1_.resize(n);
+    y1_.resize(n);
+    x2_.resize(n);
+    y2_.resize(n);
+    area_.resize(n);
+    order_.resize(n);
+
+    float max_coord = 0.f;
+    for (int i = 0; i < n; i++) {
+        const cv::Rect_<float> &r = proposals[i].rect;
+        x1_[i] = r.x;
+        y1_[i] = r.y;
+        x2_[i] = r.x + r.width;
+        y2_[i] = r.y + r.height;
+        area_[i] = r.width * r.height;
+        order_[i] = i;
+        max_coord = std::max(max_coord, std::max(x2_[i], y2_[i]));
+    }
+
+    // 按类别nms时把不同类别的框平移到互不重叠的区域，一次nms即可完成
+    if (!options_.class_agnostic) {
+        const float offset = max_coord + 1.f;
+        for (int i = 0; i < n; i++) {
+            const float shift = proposals[i].label * offset;
+            x1_[i] += shift;
+            y1_[i] += shift;
+            x2_[i] += shift;
+            y2_[i] += shift;
+        }
+    }
+
+    auto by_score = [&proposals](int a, int b) {
+        return proposals[a].prob > proposals[b].prob;
+    };
+    int num_candidates = n;
+    if (options_.pre_nms_topk > 0 && options_.pre_nms_topk < n) {
+        num_candidates = options_.pre_nms_topk;
+        std::partial_sort(order_.begin(), order_.begin() + num_candidates, order_.end(), by_score);
+    } else {
+        std::stable_sort(order_.begin(), order_.end(), by_score);
+    }
+
+    const int max_det = options_.max_det > 0 ? std::min(options_.max_det, num_candidates) : num_candidates;
+    kx1_.resize(max_det);
+    ky1_.resize(max_det);
+    kx2_.resize(max_det);
+    ky2_.resize(max_det);
+    karea_.resize(max_det);
+
+    int num_keep = 0;
+    for (int k = 0; k < num_candidates; k++) {
+        const int i = order_[k];
+        const float x1 = x1_[i];
+        const float y1 = y1_[i];
+        const float x2 = x2_[i];
+        const float y2 = y2_[i];
+        const float area = area_[i];
+
+        bool suppressed = false;
+        for (int t = 0; t < num_keep; t++) {
+            const float iw = std::min(x2, kx2_[t]) - std::max(x1, kx1_[t]);
+            const float ih = std::min(y2, ky2_[t]) - std::max(y1, ky1_[t]);
+            if (iw <= 0.f || ih <= 0.f) continue;
+            const float inter = iw * ih;
+            if (inter > iou_threshold * (area + karea_[t] - inter)) {
+                suppressed = true;
+                break;
+            }
+        }
+        if (suppressed) continue;
+
+        kx1_[num_keep] = x1;
+        ky1_[num_keep] = y1;
+        kx2_[num_keep] = x2;
+        ky2_[num_keep] = y2;
+        karea_[num_keep] = area;
+        num_keep++;
+        keep.push_back(i);
+
+        if (num_keep == max_det) break;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 14:05
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_NMS_H
+#define ZHANGCHAO_NMS_H
+
+#include <vector>
+#include "common.h"
+
+struct NmsOptions {
+    // true: 所有类别一起做nms（与原cv::dnn::NMSBoxes行为一致），false: 按类别做nms
+    bool class_agnostic = true;
+    // nms前按分数保留的最大候选数，<=0不限制
+    int pre_nms_topk = 30000;
+    // nms后保留的最大结果数，<=0不限制，达到后提前结束
+    int max_det = 0;
+};
+
+/**
+ * 贪心nms，框按SoA存储，内部缓冲区在多帧之间复用
+ */
+class NmsEngine {
+public:
+    NmsEngine() = default;
+
+    explicit NmsEngine(const NmsOptions &options) : options_(options) {}
+
+    void set_options(const NmsOptions &options) { options_ = options; }
+
+    const NmsOptions &options() const { return options_; }
+
+    /**
+     * 执行nms
+     * @param proposals 候选框，坐标为网络输入尺度
+     * @param iou_threshold iou阈值，大于该值的低分框被抑制
+     * @param keep 保留的候选框下标，按分数从高到低
+     */
+    void run(const std::vector<Object> &proposals, float iou_threshold, std::vector<int> &keep);
+
+private:
+    NmsOptions options_;
+
+    // 候选框，按proposals的下标存放
+    std::vector<float> x1_;
+    std::vector<float> y1_;
+    std::vector<float> x2_;
+    std::vector<float> y2_;
+    std::vector<float> area_;
+    std::vector<int> order_;
+
+    // 已保留的框，连续存放方便内层循环
+    std::vector<float> kx1_;
+    std::vector<float> ky1_;
+    std::vector<float> kx2_;
+    std::vector<float> ky2_;
+    std::vector<float> karea_;
+};
+
+#endif //ZHANGCHAO_NMS_H
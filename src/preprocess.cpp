@@ -0,0 +1,162 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 16:40
+ * @version V1.0
+ * @since C++11
+**/
+#include <algorithm>
+#include <cmath>
+#include "preprocess.h"
+
+LetterboxInfo letterbox(int img_w, int img_h, int new_w, int new_h, bool auto_, bool scaleup, int stride) {
+    // Resize and pad image while meeting stride-multiple constraints
+    if (new_w == 0) new_w = new_h;
+    if (new_h == 0) new_h = new_w;
+
+    // Scale ratio (new / old)
+    double r = std::min(new_h / static_cast<double>(img_h), new_w / static_cast<double>(img_w));
+    if (!scaleup) {  // only scale down, do not scale up (for better val mAP)
+        r = std::min(r, 1.0);
+    }
+
+    // Compute padding
+    const int unpad_w = static_cast<int>(std::round(img_w * r));
+    const int unpad_h = static_cast<int>(std::round(img_h * r));
+
+    double dw = new_w - unpad_w;
+    double dh = new_h - unpad_h;
+
+    if (auto_) {  // minimum rectangle
+        dw = std::fmod(dw, stride);
+        dh = std::fmod(dh, stride);
+    }
+
+    dw /= 2.0;  // divide padding into 2 sides
+    dh /= 2.0;
+
+    int top = static_cast<int>(std::round(dh - 0.1));
+    int bottom = static_cast<int>(std::round(dh + 0.1));
+    int left = static_cast<int>(std::round(dw - 0.1));
+    int right = static_cast<int>(std::round(dw + 0.1));
+
+    LetterboxInfo info;
+    info.dst_w = unpad_w + left + right;
+    info.dst_h = unpad_h + top + bottom;
+    info.resized_w = unpad_w;
+    info.resized_h = unpad_h;
+    info.left = left;
+    info.top = top;
+    info.scale = static_cast<float>(r);
+    return info;
+}
+
+// 与opencv/ncnn一致的像素中心对齐方式计算源坐标和插值权重
+static void resize_table(int src_size, int dst_size, std::vector<int> &ofs, std::vector<float> &alpha) {
+    ofs.resize(dst_size);
+    alpha.resize(dst_size);
+    const float scale = (float) src_size / dst_size;
+    for (int i = 0; i < dst_size; i++) {
+        float fx = (i + 0.5f) * scale - 0.5f;
+        int sx = (int) floorf(fx);
+        fx -= sx;
+        if (sx < 0) {
+            sx = 0;
+            fx = 0.f;
+        }
+        if (sx >= src_size - 1) {
+            sx = src_size > 1 ? src_size - 2 : 0;
+            fx = src_size > 1 ? 1.f : 0.f;
+        }
+        ofs[i] = sx;
+        alpha[i] = fx;
+    }
+}
+
+void LetterboxPreprocessor::prepare_tables(int img_w, int img_h, const LetterboxInfo &info) {
+    if (img_w == table_img_w_ && img_h == table_img_h_
+        && info.resized_w == table_resized_w_ && info.resized_h == table_resized_h_) {
+        return;
+    }
+    resize_table(img_w, info.resized_w, xofs_, xalpha_);
+    resize_table(img_h, info.resized_h, yofs_, yalpha_);
+    // 换算成字节偏移，内层循环不再乘3
+    for (int &x: xofs_) {
+        x *= 3;
+    }
+    table_img_w_ = img_w;
+    table_img_h_ = img_h;
+    table_resized_w_ = info.resized_w;
+    table_resized_h_ = info.resized_h;
+}
+
+void LetterboxPreprocessor::run(const unsigned char *bgr, int img_w, int img_h, int stride,
+                                const LetterboxInfo &info, ncnn::Mat &in, float pad_value, int num_threads) {
+    prepare_tables(img_w, img_h, info);
+
+    if (in.w != info.dst_w || in.h != info.dst_h || in.c != 3 || in.elemsize != 4u) {
+        in.create(info.dst_w, info.dst_h, 3, (size_t) 4u);
+    }
+
+    const float norm = 1 / 255.f;
+    const float pad = pad_value * norm;
+    const int xstep = img_w > 1 ? 3 : 0;
+    const int ystep = img_h > 1 ? stride : 0;
+    const int *xofs = xofs_.data();
+    const float *xalpha = xalpha_.data();
+    const int dst_w = info.dst_w;
+    const int x_begin = info.left;
+    const int x_end = info.left + info.resized_w;
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int y = 0; y < info.dst_h; y++) {
+        float *outr = in.channel(0).row(y);
+        float *outg = in.channel(1).row(y);
+        float *outb = in.channel(2).row(y);
+
+        const int sy = y - info.top;
+        if (sy < 0 || sy >= info.resized_h) {
+            for (int x = 0; x < dst_w; x++) {
+                outr[x] = pad;
+                outg[x] = pad;
+                outb[x] = pad;
+            }
+            continue;
+        }
+
+        for (int x = 0; x < x_begin; x++) {
+            outr[x] = pad;
+            outg[x] = pad;
+            outb[x] = pad;
+        }
+
+        // 归一化系数直接乘进纵向权重
+        const unsigned char *row0 = bgr + (size_t) yofs_[sy] * stride;
+        const unsigned char *row1 = row0 + ystep;
+        const float b1 = yalpha_[sy] * norm;
+        const float b0 = norm - b1;
+        for (int x = x_begin; x < x_end; x++) {
+            const int sx = xofs[x - x_begin];
+            const float a1 = xalpha[x - x_begin];
+            const float a0 = 1.f - a1;
+            const unsigned char *p0 = row0 + sx;
+            const unsigned char *p1 = row1 + sx;
+
+            const float top_b = p0[0] * a0 + p0[xstep] * a1;
+            const float top_g = p0[1] * a0 + p0[xstep + 1] * a1;
+            const float top_r = p0[2] * a0 + p0[xstep + 2] * a1;
+            const float bot_b = p1[0] * a0 + p1[xstep] * a1;
+            const float bot_g = p1[1] * a0 + p1[xstep + 1] * a1;
+            const float bot_r = p1[2] * a0 + p1[xstep + 2] * a1;
+
+            outr[x] = top_r * b0 + bot_r * b1;
+            outg[x] = top_g * b0 + bot_g * b1;
+            outb[x] = top_b * b0 + bot_b * b1;
+        }
+
+        for (int x = x_end; x < dst_w; x++) {
+            outr[x] = pad;
+            outg[x] = pad;
+            outb[x] = pad;
+        }
+    }
+}
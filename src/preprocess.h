@@ -0,0 +1,79 @@
+/**
+ * @author mpj
+ * @date 2026/10/17 16:40
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_PREPROCESS_H
+#define ZHANGCHAO_PREPROCESS_H
+
+#include <vector>
+#include <ncnn/mat.h>
+
+/**
+ * letterbox的几何参数，坐标映射：网络输入 = 原图 * scale + (left, top)
+ */
+struct LetterboxInfo {
+    int dst_w = 0;       // 网络输入宽
+    int dst_h = 0;       // 网络输入高
+    int resized_w = 0;   // 缩放后的图像宽
+    int resized_h = 0;   // 缩放后的图像高
+    int left = 0;        // 左侧填充
+    int top = 0;         // 上方填充
+    float scale = 1.f;   // 缩放比例
+};
+
+/**
+ * 计算letterbox的几何参数（与ultralytics的letterbox一致）
+ * @param img_w 原图宽
+ * @param img_h 原图高
+ * @param new_w 网络输入宽
+ * @param new_h 网络输入高
+ * @param auto_ true时只填充到stride的整数倍（最小矩形）
+ * @param scaleup false时只缩小不放大
+ * @param stride auto_的对齐步长
+ */
+LetterboxInfo letterbox(int img_w, int img_h, int new_w = 640, int new_h = 640, bool auto_ = true,
+                        bool scaleup = true, int stride = 32);
+
+/**
+ * 融合的letterbox预处理：双线性缩放、BGR转RGB、填充和1/255归一化在一次遍历中完成，
+ * 直接写入复用的输入Mat，不产生中间图像
+ *
+ * 与ncnn的 from_pixels_resize + copy_make_border + substract_mean_normalize 不逐位一致：
+ * ncnn用11位定点权重插值并把缩放结果取整为uint8，这里插值结果保持float不取整，
+ * 每个像素相差不超过1个灰度级（归一化后1/255），填充区域完全相同
+ */
+class LetterboxPreprocessor {
+public:
+    LetterboxPreprocessor() = default;
+
+    /**
+     * @param bgr 原图数据，BGR三通道
+     * @param img_w 原图宽
+     * @param img_h 原图高
+     * @param stride 原图每行字节数
+     * @param info letterbox几何参数
+     * @param in 输出的网络输入，尺寸不变时复用已有内存
+     * @param pad_value 填充值（归一化前）
+     * @param num_threads 线程数
+     */
+    void run(const unsigned char *bgr, int img_w, int img_h, int stride, const LetterboxInfo &info,
+             ncnn::Mat &in, float pad_value = 114.f, int num_threads = 1);
+
+private:
+    void prepare_tables(int img_w, int img_h, const LetterboxInfo &info);
+
+    // 插值表只和几何参数有关，视频流中尺寸不变时不必重算
+    int table_img_w_ = 0;
+    int table_img_h_ = 0;
+    int table_resized_w_ = 0;
+    int table_resized_h_ = 0;
+    std::vector<int> xofs_;
+    std::vector<float> xalpha_;
+    std::vector<int> yofs_;
+    std::vector<float> yalpha_;
+};
+
+#endif //ZHANGCHAO_PREPROCESS_H
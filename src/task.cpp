@@ -2,17 +2,73 @@
 #define PROP_VALUE_MAX 92
 #endif
 
+#include <atomic>
+#include <thread>
 #include "task.h"
 #include "yolo11.h"
+#include "lockfree_queue.h"
 #include "byte_track/BYTETracker.h"
 
 namespace ZhangChao
 {
+	// 把一条轨迹转换成对外的ObjectCLs
+	static inline void track_to_object(const STrack& track, ObjectCLs& obj)
+	{
+		obj.x = track.tlwh[0];
+		obj.y = track.tlwh[1];
+		obj.w = track.tlwh[2];
+		obj.h = track.tlwh[3];
+		obj.labelId = track.class_id;
+		obj.prob = track.score;
+		obj.clsId = -1;
+		obj.clsProb = -1;
+		obj.trackId = track.track_id;
+	}
+
+	// 把跟踪器内部的轨迹直接写入调用方的ObjectCLs，objects的容量足够时不分配内存
+	static void tracks_to_objects(const TrackSpan& tracks, std::vector<ObjectCLs>& objects)
+	{
+		objects.resize(tracks.size());
+		for (size_t i = 0; i < tracks.size(); i++)
+		{
+			track_to_object(tracks[i], objects[i]);
+		}
+	}
+
+	// 写入调用方预先分配的缓冲区，最多写capacity个，返回轨迹总数
+	static int tracks_to_objects(const TrackSpan& tracks, ObjectCLs* objects, int capacity)
+	{
+		const int n = (int)tracks.size();
+		for (int i = 0; i < n && i < capacity; i++)
+		{
+			track_to_object(tracks[i], objects[i]);
+		}
+		return n;
+	}
+
 	class bTask : public Task
 	{
 	private:
 		Yolov11* model = nullptr;
 		BYTETracker* tracker = nullptr;
+		std::vector<int> filter_; // 当前生效的类别过滤
+		std::vector<Object> yolo_objects_; // 检测结果，每帧复用
+
+		void detect(cv::Mat& bgr, float confidence_threshold, float nms_threshold, const std::vector<int>& filter)
+		{
+			if (!bgr.isContinuous())
+			{
+				bgr = bgr.clone();
+			}
+			// 类别过滤下推到解码阶段，只有过滤条件变化时才重新编译
+			if (filter != filter_)
+			{
+				filter_ = filter;
+				model->set_class_filter(filter_);
+			}
+			yolo_objects_.clear();
+			model->detect(bgr, yolo_objects_, confidence_threshold, nms_threshold);
+		}
 
 	public:
 		~bTask() override
@@ -21,60 +77,515 @@ namespace ZhangChao
 			std::cout << "bTask destructor!" << std::endl;
 		}
 
-		bool infer(cv::Mat& bgr, float confidence_threshold, float nms_threshold, std::vector<int> filter,
+		bool infer(cv::Mat& bgr, float confidence_threshold, float nms_threshold, const std::vector<int>& filter,
 			std::vector<ObjectCLs>& objects) override
 		{
-			objects.clear();
-			if (!bgr.isContinuous())
+			detect(bgr, confidence_threshold, nms_threshold, filter);
+			tracks_to_objects(tracker->update_tracks(yolo_objects_), objects);
+			return true;
+		}
+
+		int infer(cv::Mat& bgr, float confidence_threshold, float nms_threshold, const std::vector<int>& filter,
+			ObjectCLs* objects, int capacity) override
+		{
+			detect(bgr, confidence_threshold, nms_threshold, filter);
+			return tracks_to_objects(tracker->update_tracks(yolo_objects_), objects, capacity);
+		}
+
+		bool load(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
+			unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU, bool use_mmap)
+		{
+			model = new Yolov11();
+			if (!model->load_model(yolo_param_path.c_str(), yolo_bin_path.c_str(), yolo_input_size, isGPU,
+				yolo_param_key, yolo_bin_key, use_mmap))
 			{
-				bgr = bgr.clone();
+				std::cerr << "load YOLOv5 model failed" << std::endl;
+				return false;
 			}
-			std::vector<Object> yolo_objects;
-			model->detect(bgr, yolo_objects, confidence_threshold, nms_threshold);
+			tracker = new BYTETracker(30, 30);
+
+			std::cout << "load model success!" << std::endl;
+			return true;
+		}
+	};
+
+	class bAsyncTask : public AsyncTask
+	{
+	private:
+		// 流水线中的一帧，一共depth个，处理完后放回free_queue_复用
+		struct FrameJob
+		{
+			int64_t index = 0;
+			cv::Mat bgr;
+			DetectContext ctx;
+			std::vector<Object> objects;
+			bool ok = false;
+			bool has_promise = false;
+			std::promise<std::vector<ObjectCLs>> promise;
+			Callback callback;
+		};
 
-			std::vector<STrack> tracks = tracker->update(yolo_objects);
+		using JobQueue = LockFreeQueue<FrameJob*>;
 
-			for (auto& track : tracks)
+		Yolov11* model = nullptr;
+		BYTETracker* tracker = nullptr;
+		PipelineOptions options_;
+		std::vector<std::unique_ptr<FrameJob>> jobs_;
+		std::unique_ptr<JobQueue> free_queue_;
+		std::unique_ptr<JobQueue> preprocess_queue_;
+		std::unique_ptr<JobQueue> infer_queue_;
+		std::unique_ptr<JobQueue> postprocess_queue_;
+		std::unique_ptr<JobQueue> track_queue_;
+		std::vector<std::thread> threads_;
+		std::atomic<bool> stop_{ false };
+		std::atomic<int64_t> submitted_{ 0 };
+		std::atomic<int64_t> finished_{ 0 };
+
+	public:
+		~bAsyncTask() override
+		{
+			wait_idle();
+			stop_.store(true, std::memory_order_release);
+			for (auto& thread : threads_)
 			{
-				ObjectCLs obj;
-				obj.x = track.tlwh[0];
-				obj.y = track.tlwh[1];
-				obj.w = track.tlwh[2];
-				obj.h = track.tlwh[3];
-				obj.labelId = track.class_id;
-				obj.prob = track.score;
-				obj.clsId = -1;
-				obj.clsProb = -1;
-				obj.trackId = track.track_id;
-				objects.push_back(obj);
+				thread.join();
 			}
+			delete model;
+			delete tracker;
+			std::cout << "bAsyncTask destructor!" << std::endl;
+		}
 
+		std::future<std::vector<ObjectCLs>> submit(const cv::Mat& bgr) override
+		{
+			FrameJob* job = acquire();
+			job->bgr = bgr.isContinuous() ? bgr : bgr.clone();
+			job->promise = std::promise<std::vector<ObjectCLs>>();
+			job->has_promise = true;
+			std::future<std::vector<ObjectCLs>> future = job->promise.get_future();
+			job->index = submitted_.fetch_add(1);
+			push(*preprocess_queue_, job);
+			return future;
+		}
+
+		int64_t submit(const cv::Mat& bgr, Callback callback) override
+		{
+			FrameJob* job = acquire();
+			job->bgr = bgr.isContinuous() ? bgr : bgr.clone();
+			job->callback = std::move(callback);
+			job->has_promise = false;
+			const int64_t index = submitted_.fetch_add(1);
+			job->index = index;
+			push(*preprocess_queue_, job);
+			return index;
+		}
+
+		void wait_idle() override
+		{
+			Backoff backoff;
+			while (finished_.load(std::memory_order_acquire) != submitted_.load(std::memory_order_acquire))
+			{
+				backoff.pause();
+			}
+		}
+
+		bool load(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
+			const PipelineOptions& options, unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU)
+		{
+			model = new Yolov11();
+			if (!model->load_model(yolo_param_path.c_str(), yolo_bin_path.c_str(), yolo_input_size, isGPU,
+				yolo_param_key, yolo_bin_key, options.use_mmap))
+			{
+				std::cerr << "load YOLOv5 model failed" << std::endl;
+				return false;
+			}
+			model->set_class_filter(options.filter);
+			tracker = new BYTETracker(30, 30);
+
+			options_ = options;
+			options_.depth = std::max(1, options_.depth);
+			options_.preprocess_threads = std::max(1, options_.preprocess_threads);
+			options_.infer_threads = std::max(1, options_.infer_threads);
+			options_.postprocess_threads = std::max(1, options_.postprocess_threads);
+			if (options_.infer_num_threads <= 0)
+			{
+				options_.infer_num_threads = std::max(1, ncnn::get_big_cpu_count() / options_.infer_threads);
+			}
+
+			const int depth = options_.depth;
+			free_queue_.reset(new JobQueue(depth));
+			preprocess_queue_.reset(new JobQueue(depth));
+			infer_queue_.reset(new JobQueue(depth));
+			postprocess_queue_.reset(new JobQueue(depth));
+			track_queue_.reset(new JobQueue(depth));
+			for (int i = 0; i < depth; i++)
+			{
+				jobs_.emplace_back(new FrameJob());
+				free_queue_->try_push(jobs_.back().get());
+			}
+
+			for (int i = 0; i < options_.preprocess_threads; i++)
+			{
+				threads_.emplace_back(&bAsyncTask::preprocess_worker, this);
+			}
+			for (int i = 0; i < options_.infer_threads; i++)
+			{
+				threads_.emplace_back(&bAsyncTask::infer_worker, this);
+			}
+			for (int i = 0; i < options_.postprocess_threads; i++)
+			{
+				threads_.emplace_back(&bAsyncTask::postprocess_worker, this);
+			}
+			// 跟踪必须按帧顺序进行，只有一个线程
+			threads_.emplace_back(&bAsyncTask::track_worker, this);
+
+			std::cout << "load model success!" << std::endl;
 			return true;
 		}
 
+	private:
+		FrameJob* acquire()
+		{
+			FrameJob* job = nullptr;
+			Backoff backoff;
+			while (!free_queue_->try_pop(job))
+			{
+				backoff.pause();
+			}
+			return job;
+		}
+
+		static void push(JobQueue& queue, FrameJob* job)
+		{
+			Backoff backoff;
+			while (!queue.try_push(job))
+			{
+				backoff.pause();
+			}
+		}
+
+		// 停止时返回nullptr
+		FrameJob* pop(JobQueue& queue)
+		{
+			FrameJob* job = nullptr;
+			Backoff backoff;
+			while (!queue.try_pop(job))
+			{
+				if (stop_.load(std::memory_order_acquire))
+				{
+					return nullptr;
+				}
+				backoff.pause();
+			}
+			return job;
+		}
+
+		void preprocess_worker()
+		{
+			while (FrameJob* job = pop(*preprocess_queue_))
+			{
+				model->preprocess(job->bgr, job->ctx);
+				push(*infer_queue_, job);
+			}
+		}
+
+		void infer_worker()
+		{
+			// 每个推理线程独立的allocator，输出blob会在其他线程释放，所以用带锁的PoolAllocator
+			ncnn::PoolAllocator blob_allocator;
+			ncnn::PoolAllocator workspace_allocator;
+			blob_allocator.set_size_compare_ratio(0.f);
+			workspace_allocator.set_size_compare_ratio(0.f);
+			while (FrameJob* job = pop(*infer_queue_))
+			{
+				job->ok = model->forward(job->ctx, &blob_allocator, &workspace_allocator, options_.infer_num_threads);
+				push(*postprocess_queue_, job);
+			}
+		}
+
+		void postprocess_worker()
+		{
+			while (FrameJob* job = pop(*postprocess_queue_))
+			{
+				job->objects.clear();
+				if (job->ok)
+				{
+					model->postprocess(job->ctx, job->objects, options_.confidence_threshold, options_.nms_threshold);
+				}
+				// 尽早把输出blob还给推理线程的allocator
+				for (auto& out : job->ctx.outs)
+				{
+					out.release();
+				}
+				push(*track_queue_, job);
+			}
+		}
+
+		void track_worker()
+		{
+			// 解码线程可能乱序完成，按帧序号重新排序后再送入跟踪器
+			ReorderBuffer<FrameJob> reorder(options_.depth);
+			while (FrameJob* job = pop(*track_queue_))
+			{
+				reorder.put(job->index, job, [this](FrameJob* ready) { finish(ready); });
+			}
+		}
+
+		void finish(FrameJob* job)
+		{
+			std::vector<ObjectCLs> objects;
+			if (job->ok)
+			{
+				tracks_to_objects(tracker->update_tracks(job->objects), objects);
+			}
+
+			if (job->has_promise)
+			{
+				job->promise.set_value(std::move(objects));
+			}
+			else if (job->callback)
+			{
+				job->callback(job->index, objects);
+			}
+
+			job->bgr.release();
+			job->callback = nullptr;
+			job->has_promise = false;
+			finished_.fetch_add(1, std::memory_order_release);
+			push(*free_queue_, job);
+		}
+	};
+
+	class bMultiStreamTask : public MultiStreamTask
+	{
+	private:
+		struct StreamFrame
+		{
+			int64_t index = 0;
+			cv::Mat bgr;
+		};
+
+		// 一路视频的全部状态，同一时刻只被一个工作线程持有，所以allocator不需要加锁
+		struct Stream
+		{
+			int id = 0;
+			std::unique_ptr<LockFreeQueue<StreamFrame>> queue;
+			std::atomic<bool> busy{ false };
+			BYTETracker tracker{ 30, 30 };
+			// allocator要在ctx之后析构
+			ncnn::UnlockedPoolAllocator blob_allocator;
+			ncnn::UnlockedPoolAllocator workspace_allocator;
+			DetectContext ctx;
+			std::vector<Object> objects;
+			std::vector<ObjectCLs> results;
+			std::atomic<int64_t> submitted{ 0 };
+			std::atomic<int64_t> processed{ 0 };
+			std::atomic<int64_t> dropped{ 0 };
+			std::atomic<float> fps{ 0.f };
+			std::chrono::steady_clock::time_point last_finish;
+		};
+
+		Yolov11* model = nullptr;
+		MultiStreamOptions options_;
+		Callback callback_;
+		std::vector<std::unique_ptr<Stream>> streams_;
+		std::vector<std::thread> workers_;
+		std::atomic<bool> stop_{ false };
+		std::atomic<unsigned int> cursor_{ 0 };
+
+	public:
+		~bMultiStreamTask() override
+		{
+			wait_idle();
+			stop_.store(true, std::memory_order_release);
+			for (auto& worker : workers_)
+			{
+				worker.join();
+			}
+			streams_.clear();
+			delete model;
+			std::cout << "bMultiStreamTask destructor!" << std::endl;
+		}
+
+		int64_t submit(int stream_id, const cv::Mat& bgr) override
+		{
+			if (stream_id < 0 || stream_id >= (int)streams_.size())
+			{
+				return -1;
+			}
+			Stream& stream = *streams_[stream_id];
+			StreamFrame frame;
+			frame.index = stream.submitted.fetch_add(1);
+			// 排队的帧可能被调用方复用的缓冲区覆盖（如VideoCapture::read），这里拷贝一份
+			frame.bgr = bgr.clone();
+			while (!stream.queue->try_push(frame))
+			{
+				// 实时流优先处理最新的帧
+				StreamFrame oldest;
+				if (stream.queue->try_pop(oldest))
+				{
+					stream.dropped.fetch_add(1);
+				}
+			}
+			return frame.index;
+		}
+
+		int num_streams() const override
+		{
+			return (int)streams_.size();
+		}
+
+		StreamStats stats(int stream_id) const override
+		{
+			StreamStats stats;
+			if (stream_id < 0 || stream_id >= (int)streams_.size())
+			{
+				return stats;
+			}
+			const Stream& stream = *streams_[stream_id];
+			stats.submitted = stream.submitted.load();
+			stats.processed = stream.processed.load();
+			stats.dropped = stream.dropped.load();
+			stats.fps = stream.fps.load();
+			return stats;
+		}
+
+		void wait_idle() override
+		{
+			Backoff backoff;
+			for (auto& stream : streams_)
+			{
+				while (stream->processed.load() + stream->dropped.load() != stream->submitted.load())
+				{
+					backoff.pause();
+				}
+			}
+		}
+
 		bool load(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
+			int num_streams, const MultiStreamOptions& options, Callback callback,
 			unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU)
 		{
 			model = new Yolov11();
 			if (!model->load_model(yolo_param_path.c_str(), yolo_bin_path.c_str(), yolo_input_size, isGPU,
-				yolo_param_key, yolo_bin_key))
+				yolo_param_key, yolo_bin_key, options.use_mmap))
 			{
 				std::cerr << "load YOLOv5 model failed" << std::endl;
 				return false;
 			}
-			tracker = new BYTETracker(30, 30);
+			model->set_class_filter(options.filter);
+
+			options_ = options;
+			options_.num_workers = std::max(1, options_.num_workers);
+			options_.queue_size = std::max(1, options_.queue_size);
+			if (options_.worker_num_threads <= 0)
+			{
+				options_.worker_num_threads = std::max(1, ncnn::get_big_cpu_count() / options_.num_workers);
+			}
+			callback_ = std::move(callback);
+
+			for (int i = 0; i < num_streams; i++)
+			{
+				std::unique_ptr<Stream> stream(new Stream());
+				stream->id = i;
+				stream->queue.reset(new LockFreeQueue<StreamFrame>(options_.queue_size));
+				stream->blob_allocator.set_size_compare_ratio(0.f);
+				stream->workspace_allocator.set_size_compare_ratio(0.f);
+				streams_.push_back(std::move(stream));
+			}
+
+			for (int i = 0; i < options_.num_workers; i++)
+			{
+				workers_.emplace_back(&bMultiStreamTask::worker, this);
+			}
 
 			std::cout << "load model success!" << std::endl;
 			return true;
 		}
+
+	private:
+		// 从游标开始轮询，取一路空闲且有帧的视频，保证各路公平
+		Stream* acquire(StreamFrame& frame)
+		{
+			const unsigned int n = (unsigned int)streams_.size();
+			const unsigned int start = cursor_.fetch_add(1);
+			for (unsigned int k = 0; k < n; k++)
+			{
+				Stream& stream = *streams_[(start + k) % n];
+				bool expected = false;
+				if (stream.busy.load(std::memory_order_relaxed)
+					|| !stream.busy.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				{
+					continue;
+				}
+				if (stream.queue->try_pop(frame))
+				{
+					return &stream;
+				}
+				stream.busy.store(false, std::memory_order_release);
+			}
+			return nullptr;
+		}
+
+		void worker()
+		{
+			StreamFrame frame;
+			Backoff backoff;
+			while (!stop_.load(std::memory_order_acquire))
+			{
+				Stream* stream = acquire(frame);
+				if (!stream)
+				{
+					backoff.pause();
+					continue;
+				}
+				backoff.reset();
+
+				process(*stream, frame);
+				frame.bgr.release();
+				stream->busy.store(false, std::memory_order_release);
+			}
+		}
+
+		void process(Stream& stream, StreamFrame& frame)
+		{
+			stream.objects.clear();
+			model->preprocess(frame.bgr, stream.ctx);
+			if (model->forward(stream.ctx, &stream.blob_allocator, &stream.workspace_allocator,
+				options_.worker_num_threads))
+			{
+				model->postprocess(stream.ctx, stream.objects, options_.confidence_threshold, options_.nms_threshold);
+			}
+			for (auto& out : stream.ctx.outs)
+			{
+				out.release();
+			}
+
+			tracks_to_objects(stream.tracker.update_tracks(stream.objects), stream.results);
+			if (callback_)
+			{
+				callback_(stream.id, frame.index, stream.results);
+			}
+
+			auto now = std::chrono::steady_clock::now();
+			if (stream.processed.load(std::memory_order_relaxed) > 0)
+			{
+				float dt = std::chrono::duration<float>(now - stream.last_finish).count();
+				float fps = dt > 0.f ? 1.f / dt : 0.f;
+				float last = stream.fps.load(std::memory_order_relaxed);
+				stream.fps.store(last > 0.f ? last * 0.9f + fps * 0.1f : fps, std::memory_order_relaxed);
+			}
+			stream.last_finish = now;
+			stream.processed.fetch_add(1, std::memory_order_release);
+		}
 	};
 
 	std::shared_ptr<Task>
 	load(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
-			unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU)
+			unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU, bool use_mmap)
 	{
 		auto* task = new bTask();
-		if (!task->load(yolo_param_path, yolo_bin_path, yolo_input_size, yolo_param_key, yolo_bin_key, isGPU))
+		if (!task->load(yolo_param_path, yolo_bin_path, yolo_input_size, yolo_param_key, yolo_bin_key, isGPU,
+			use_mmap))
 		{
 			delete task;
 			return nullptr;
@@ -82,4 +593,35 @@ namespace ZhangChao
 
 		return std::shared_ptr<Task>(task);
 	}
+
+	std::shared_ptr<AsyncTask>
+	load_async(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
+			const PipelineOptions& options, unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU)
+	{
+		auto* task = new bAsyncTask();
+		if (!task->load(yolo_param_path, yolo_bin_path, yolo_input_size, options, yolo_param_key, yolo_bin_key,
+			isGPU))
+		{
+			delete task;
+			return nullptr;
+		}
+
+		return std::shared_ptr<AsyncTask>(task);
+	}
+
+	std::shared_ptr<MultiStreamTask>
+	load_multi_stream(const std::string& yolo_param_path, const std::string& yolo_bin_path, int yolo_input_size,
+			int num_streams, const MultiStreamOptions& options, MultiStreamTask::Callback callback,
+			unsigned char yolo_param_key, unsigned char yolo_bin_key, bool isGPU)
+	{
+		auto* task = new bMultiStreamTask();
+		if (!task->load(yolo_param_path, yolo_bin_path, yolo_input_size, num_streams, options, std::move(callback),
+			yolo_param_key, yolo_bin_key, isGPU))
+		{
+			delete task;
+			return nullptr;
+		}
+
+		return std::shared_ptr<MultiStreamTask>(task);
+	}
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #ifndef ZHANGCHAO_TASK_H
 #define ZHANGCHAO_TASK_H
 
+#include <functional>
+#include <future>
 #include <opencv2/opencv.hpp>
 
 
@@ -32,12 +34,120 @@ namespace ZhangChao {
          * @param rgb 一帧rgb格式的图片
          * @param confidence_threshold 置信度阈值
          * @param nms_threshold nms阈值
-         * @param filter 需要保留的类别，空对象不过滤
+         * @param filter 需要保留的类别，空对象不过滤；负数和超出模型类别数的id被忽略，
+         *               非空但没有合法id（如{-1}）时不返回任何目标；与上一次相同时不会重新编译
          * @param objects 返回的检测结果
          * @return 是否成功
          */
-        virtual bool infer(cv::Mat &bgr, float confidence_threshold, float nms_threshold, std::vector<int> filter,
-                           std::vector<ObjectCLs> &objects) = 0;
+        virtual bool infer(cv::Mat &bgr, float confidence_threshold, float nms_threshold,
+                           const std::vector<int> &filter, std::vector<ObjectCLs> &objects) = 0;
+
+        /**
+         * 进行推理，跟踪结果直接写入调用方预先分配的缓冲区，不经过std::vector
+         * @param objects 调用方的缓冲区
+         * @param capacity 缓冲区能放下的目标数，目标更多时只写前capacity个
+         * @return 目标总数，可能大于capacity
+         */
+        virtual int infer(cv::Mat &bgr, float confidence_threshold, float nms_threshold,
+                          const std::vector<int> &filter, ObjectCLs *objects, int capacity) = 0;
+    };
+
+    /**
+     * 异步流水线的配置：预处理 -> 推理 -> 解码+nms -> 跟踪，各阶段之间用无锁队列连接
+     */
+    struct PipelineOptions {
+        int depth = 4;                      // 同时在流水线中的最大帧数，满了之后submit会阻塞
+        int preprocess_threads = 1;         // 预处理线程数
+        int infer_threads = 1;              // 推理线程数，每个线程一个extractor
+        int infer_num_threads = 0;          // 每个extractor的ncnn线程数，0表示大核数/infer_threads
+        int postprocess_threads = 1;        // 解码+nms线程数
+        float confidence_threshold = 0.25f; // 置信度阈值
+        float nms_threshold = 0.45f;        // nms阈值
+        std::vector<int> filter;            // 需要保留的类别，空对象不过滤，非空但没有合法id时不保留任何目标
+        bool use_mmap = false;              // 映射模型文件加载，多个进程共享权重的page cache
+    };
+
+    class AsyncTask {
+    public:
+        /**
+         * 结果回调，在跟踪线程中按提交顺序调用
+         * @param frame_index submit返回的帧序号
+         * @param objects 检测跟踪结果
+         */
+        using Callback = std::function<void(int64_t frame_index, std::vector<ObjectCLs> &objects)>;
+
+        virtual ~AsyncTask() = default;
+
+        /**
+         * 提交一帧，流水线满时阻塞
+         * 流水线持有bgr的引用直到该帧处理完，调用方在此之前不要原地改写图像
+         * @param bgr 一帧bgr格式的图片
+         * @return 该帧检测跟踪结果的future
+         */
+        virtual std::future<std::vector<ObjectCLs>> submit(const cv::Mat &bgr) = 0;
+
+        /**
+         * 提交一帧，结果通过回调返回
+         * @return 帧序号
+         */
+        virtual int64_t submit(const cv::Mat &bgr, Callback callback) = 0;
+
+        /**
+         * 等待所有已提交的帧处理完
+         */
+        virtual void wait_idle() = 0;
+    };
+
+    /**
+     * 多路视频共享一个网络的调度配置
+     */
+    struct MultiStreamOptions {
+        int num_workers = 2;                // 工作线程数，每个线程同一时刻处理一路的一帧
+        int worker_num_threads = 0;         // 每个工作线程的ncnn线程数，0表示大核数/num_workers
+        int queue_size = 2;                 // 每路最多排队的帧数，满了丢弃最旧的帧
+        float confidence_threshold = 0.25f; // 置信度阈值
+        float nms_threshold = 0.45f;        // nms阈值
+        std::vector<int> filter;            // 需要保留的类别，空对象不过滤，非空但没有合法id时不保留任何目标
+        bool use_mmap = false;              // 映射模型文件加载，多个进程共享权重的page cache
+    };
+
+    struct StreamStats {
+        int64_t submitted = 0; // 提交的帧数
+        int64_t processed = 0; // 处理完的帧数
+        int64_t dropped = 0;   // 排队满被丢弃的帧数
+        float fps = 0.f;       // 最近的处理帧率
+    };
+
+    class MultiStreamTask {
+    public:
+        /**
+         * 结果回调，在工作线程中调用，同一路的回调按帧顺序串行
+         * @param stream_id 视频路号
+         * @param frame_index 该路的帧序号
+         * @param objects 检测跟踪结果
+         */
+        using Callback = std::function<void(int stream_id, int64_t frame_index, std::vector<ObjectCLs> &objects)>;
+
+        virtual ~MultiStreamTask() = default;
+
+        /**
+         * 提交一路的一帧，不阻塞，该路排队已满时丢弃最旧的一帧
+         * 图像会被拷贝，返回后调用方可以立即复用bgr的缓冲区
+         * @return 该路的帧序号，stream_id无效时返回-1
+         */
+        virtual int64_t submit(int stream_id, const cv::Mat &bgr) = 0;
+
+        virtual int num_streams() const = 0;
+
+        /**
+         * 一路的统计信息，stream_id无效时返回全0
+         */
+        virtual StreamStats stats(int stream_id) const = 0;
+
+        /**
+         * 等待所有排队的帧处理完
+         */
+        virtual void wait_idle() = 0;
     };
 
     /**
@@ -53,6 +163,7 @@ namespace ZhangChao {
      * @param cls_param_key 分类器的param加密key
      * @param cls_bin_key 分类器的bin加密key
      * @param isGPU 是否使用GPU，默认使用CPU，在安卓中推荐使用功能CPU，安卓的GPU计算能力远不如PC
+     * @param use_mmap 映射模型文件加载，未加密的权重不拷贝，多个进程共享page cache
      * @return 返回一个Task的智能指针
      */
     std::shared_ptr<Task> load(
@@ -61,6 +172,39 @@ namespace ZhangChao {
             int yolo_input_size,
             unsigned char yolo_param_key = 0,
             unsigned char yolo_bin_key = 0,
+            bool isGPU = false,
+            bool use_mmap = false);
+
+    /**
+     * 创建异步流水线任务，参数同load
+     * @param options 流水线配置
+     * @return 返回一个AsyncTask的智能指针
+     */
+    std::shared_ptr<AsyncTask> load_async(
+            const std::string &yolo_param_path,
+            const std::string &yolo_bin_path,
+            int yolo_input_size,
+            const PipelineOptions &options,
+            unsigned char yolo_param_key = 0,
+            unsigned char yolo_bin_key = 0,
+            bool isGPU = false);
+
+    /**
+     * 创建多路任务，网络只加载一次，每路有独立的跟踪器和allocator，模型参数同load
+     * @param num_streams 视频路数
+     * @param options 调度配置
+     * @param callback 结果回调
+     * @return 返回一个MultiStreamTask的智能指针
+     */
+    std::shared_ptr<MultiStreamTask> load_multi_stream(
+            const std::string &yolo_param_path,
+            const std::string &yolo_bin_path,
+            int yolo_input_size,
+            int num_streams,
+            const MultiStreamOptions &options,
+            MultiStreamTask::Callback callback,
+            unsigned char yolo_param_key = 0,
+            unsigned char yolo_bin_key = 0,
             bool isGPU = false);
 }
 
@@ -0,0 +1,169 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 10:20
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_WORK_STEALING_POOL_H
+#define ZHANGCHAO_WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 工作窃取线程池，parallel_for把任务按连续区间分到每个线程自己的队列里，
+ * 线程从自己队列的尾部取任务，队列空了再从其它线程队列的头部窃取，耗时不均的任务也能均衡。
+ * 调用线程作为0号线程参与执行，同一时间只执行一个parallel_for，队列在多次调用之间复用
+ */
+class WorkStealingPool {
+public:
+    // num_threads包含调用线程，<=0时使用硬件线程数
+    explicit WorkStealingPool(int num_threads = 0) {
+        if (num_threads <= 0) {
+            num_threads = std::max(1, (int) std::thread::hardware_concurrency());
+        }
+        queues_.reset(new TaskQueue[num_threads]);
+        num_threads_ = num_threads;
+        for (int i = 1; i < num_threads; i++) {
+            threads_.emplace_back(&WorkStealingPool::worker_loop, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (size_t i = 0; i < threads_.size(); i++) {
+            threads_[i].join();
+        }
+    }
+
+    int num_threads() const { return num_threads_; }
+
+    /**
+     * 对[0, n)中的每个i执行fn(i)，全部完成后返回；fn抛出的第一个异常在调用线程重新抛出
+     */
+    void parallel_for(int n, const std::function<void(int)> &fn) {
+        if (n <= 0) return;
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+        if (num_threads_ == 1 || n == 1) {
+            for (int i = 0; i < n; i++) {
+                fn(i);
+            }
+            return;
+        }
+
+        fn_ = &fn;
+        error_ = nullptr;
+        remaining_.store(n, std::memory_order_relaxed);
+        for (int t = 0; t < num_threads_; t++) {
+            TaskQueue &queue = queues_[t];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.head = (int) ((long long) n * t / num_threads_);
+            queue.tail = (int) ((long long) n * (t + 1) / num_threads_);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_++;
+        }
+        wake_cv_.notify_all();
+
+        run_tasks(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return remaining_.load(std::memory_order_acquire) == 0; });
+        fn_ = nullptr;
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    // 任务是[head, tail)区间内的下标，自己从tail取，窃取者从head取
+    struct alignas(64) TaskQueue {
+        std::mutex mutex;
+        int head = 0;
+        int tail = 0;
+    };
+
+    bool pop(int t, int &task) {
+        TaskQueue &queue = queues_[t];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.head == queue.tail) return false;
+        task = --queue.tail;
+        return true;
+    }
+
+    bool steal(int t, int &task) {
+        for (int k = 1; k < num_threads_; k++) {
+            TaskQueue &queue = queues_[(t + k) % num_threads_];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.head != queue.tail) {
+                task = queue.head++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run_tasks(int t) {
+        int task;
+        while (pop(t, task) || steal(t, task)) {
+            try {
+                (*fn_)(task);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    void worker_loop(int t) {
+        long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            run_tasks(t);
+        }
+    }
+
+    int num_threads_;
+    std::unique_ptr<TaskQueue[]> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    long long generation_ = 0;
+    bool stop_ = false;
+    const std::function<void(int)> *fn_ = nullptr;
+    std::atomic<int> remaining_{0};
+    std::exception_ptr error_;
+};
+
+#endif //ZHANGCHAO_WORK_STEALING_POOL_H
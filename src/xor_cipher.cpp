@@ -0,0 +1,192 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 15:30
+ * @version V1.0
+ * @since C++11
+**/
+#include "xor_cipher.h"
+#include <cstring>
+#include <ncnn/cpu.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XOR_X86 1
+#include <immintrin.h>
+#else
+#define XOR_X86 0
+#endif
+
+#if __ARM_NEON && __aarch64__
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define XOR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define XOR_TARGET(isa)
+#endif
+
+// 每次处理64字节，expanded中从phase开始的64字节就是这一段的密钥
+typedef void (*xor_block_func)(const unsigned char *src, unsigned char *dst, size_t n,
+                               const unsigned char *expanded, size_t key_len, size_t phase);
+
+static inline void xor_tail(const unsigned char *src, unsigned char *dst, size_t n, const unsigned char *expanded,
+                            size_t phase) {
+    // 剩余不足64字节，phase + n < key_len + 64，不会越界
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = src[i] ^ expanded[phase + i];
+    }
+}
+
+#if !XOR_X86 && !(__ARM_NEON && __aarch64__)
+static void xor_blocks_scalar(const unsigned char *src, unsigned char *dst, size_t n,
+                              const unsigned char *expanded, size_t key_len, size_t phase) {
+    const size_t step = 64 % key_len;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        for (int j = 0; j < 64; j++) {
+            dst[i + j] = src[i + j] ^ expanded[phase + j];
+        }
+        phase += step;
+        if (phase >= key_len) phase -= key_len;
+    }
+    xor_tail(src + i, dst + i, n - i, expanded, phase);
+}
+#endif
+
+#if XOR_X86
+static void xor_blocks_sse2(const unsigned char *src, unsigned char *dst, size_t n,
+                            const unsigned char *expanded, size_t key_len, size_t phase) {
+    const size_t step = 64 % key_len;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const unsigned char *k = expanded + phase;
+        for (int j = 0; j < 64; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (src + i + j));
+            __m128i kv = _mm_loadu_si128((const __m128i *) (k + j));
+            _mm_storeu_si128((__m128i *) (dst + i + j), _mm_xor_si128(v, kv));
+        }
+        phase += step;
+        if (phase >= key_len) phase -= key_len;
+    }
+    xor_tail(src + i, dst + i, n - i, expanded, phase);
+}
+
+XOR_TARGET("avx2")
+static void xor_blocks_avx2(const unsigned char *src, unsigned char *dst, size_t n,
+                            const unsigned char *expanded, size_t key_len, size_t phase) {
+    const size_t step = 64 % key_len;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const unsigned char *k = expanded + phase;
+        __m256i v0 = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *) (src + i + 32));
+        __m256i k0 = _mm256_loadu_si256((const __m256i *) k);
+        __m256i k1 = _mm256_loadu_si256((const __m256i *) (k + 32));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_xor_si256(v0, k0));
+        _mm256_storeu_si256((__m256i *) (dst + i + 32), _mm256_xor_si256(v1, k1));
+        phase += step;
+        if (phase >= key_len) phase -= key_len;
+    }
+    xor_tail(src + i, dst + i, n - i, expanded, phase);
+}
+#endif // XOR_X86
+
+#if __ARM_NEON && __aarch64__
+static void xor_blocks_neon(const unsigned char *src, unsigned char *dst, size_t n,
+                            const unsigned char *expanded, size_t key_len, size_t phase) {
+    const size_t step = 64 % key_len;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint8x16x4_t v = vld1q_u8_x4(src + i);
+        uint8x16x4_t k = vld1q_u8_x4(expanded + phase);
+        v.val[0] = veorq_u8(v.val[0], k.val[0]);
+        v.val[1] = veorq_u8(v.val[1], k.val[1]);
+        v.val[2] = veorq_u8(v.val[2], k.val[2]);
+        v.val[3] = veorq_u8(v.val[3], k.val[3]);
+        vst1q_u8_x4(dst + i, v);
+        phase += step;
+        if (phase >= key_len) phase -= key_len;
+    }
+    xor_tail(src + i, dst + i, n - i, expanded, phase);
+}
+#endif
+
+struct XorKernel {
+    xor_block_func func;
+    const char *name;
+};
+
+static XorKernel select_xor_kernel() {
+#if XOR_X86
+    // 解密受内存带宽限制，avx512不比avx2快（bench_decrypt：avx2 4.6 GB/s，avx512 3.2 GB/s），还可能让核心降频，所以不使用
+    if (ncnn::cpu_support_x86_avx2()) {
+        return {xor_blocks_avx2, "avx2"};
+    }
+    return {xor_blocks_sse2, "sse2"};
+#elif __ARM_NEON && __aarch64__
+    return {xor_blocks_neon, "neon"};
+#else
+    return {xor_blocks_scalar, "scalar"};
+#endif
+}
+
+static const XorKernel &xor_kernel() {
+    static const XorKernel kernel = select_xor_kernel();
+    return kernel;
+}
+
+void xor_key_stream_scalar(const unsigned char *src, unsigned char *dst, size_t n, const unsigned char *key,
+                           size_t key_len, size_t offset) {
+    size_t phase = offset % key_len;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = src[i] ^ key[phase];
+        if (++phase == key_len) phase = 0;
+    }
+}
+
+XorKeyStream::XorKeyStream(const unsigned char *key, size_t key_len) {
+    set_key(key, key_len);
+}
+
+XorKeyStream::~XorKeyStream() {
+    clear();
+}
+
+void XorKeyStream::set_key(const unsigned char *key, size_t key_len) {
+    clear();
+    if (!key || key_len == 0) return;
+    key_len_ = key_len;
+    expanded_.resize(key_len + 64);
+    for (size_t i = 0; i < expanded_.size(); i++) {
+        expanded_[i] = key[i % key_len];
+    }
+    identity_ = true;
+    for (size_t i = 0; i < key_len; i++) {
+        identity_ = identity_ && key[i] == 0;
+    }
+}
+
+void XorKeyStream::clear() {
+    // 密钥不留在释放的内存里
+    if (!expanded_.empty()) {
+        volatile unsigned char *p = expanded_.data();
+        for (size_t i = 0; i < expanded_.size(); i++) {
+            p[i] = 0;
+        }
+    }
+    expanded_.clear();
+    key_len_ = 0;
+    identity_ = true;
+}
+
+void XorKeyStream::apply(const unsigned char *src, unsigned char *dst, size_t n, size_t offset) const {
+    if (identity_) {
+        if (src != dst) memcpy(dst, src, n);
+        return;
+    }
+    xor_kernel().func(src, dst, n, expanded_.data(), key_len_, offset % key_len_);
+}
+
+const char *XorKeyStream::isa_name() {
+    return xor_kernel().name;
+}
@@ -0,0 +1,56 @@
+/**
+ * @author mpj
+ * @date 2026/10/18 15:30
+ * @version V1.0
+ * @since C++11
+**/
+
+#ifndef ZHANGCHAO_XOR_CIPHER_H
+#define ZHANGCHAO_XOR_CIPHER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * 循环密钥流的异或加解密：文件中偏移为i的字节与 key[i % key_len] 异或，单字节密钥就是key_len为1的情况。
+ * 密钥预先展开成 key_len + 64 字节，任意偏移处都能直接读出连续64字节的密钥，
+ * 按CPU支持的指令集选择SSE2/AVX2（x86）或NEON（aarch64），每条指令处理16或32字节
+ */
+class XorKeyStream {
+public:
+    XorKeyStream() = default;
+
+    XorKeyStream(const unsigned char *key, size_t key_len);
+
+    ~XorKeyStream();
+
+    void set_key(const unsigned char *key, size_t key_len);
+
+    // 清除密钥
+    void clear();
+
+    // 没有密钥或者密钥全为0时不需要解密
+    bool empty() const { return identity_; }
+
+    size_t key_len() const { return key_len_; }
+
+    /**
+     * dst[i] = src[i] ^ key[(offset + i) % key_len]，src和dst可以相同
+     * @param offset src[0]在整个文件中的偏移
+     */
+    void apply(const unsigned char *src, unsigned char *dst, size_t n, size_t offset) const;
+
+    // 当前使用的指令集
+    static const char *isa_name();
+
+private:
+    std::vector<unsigned char> expanded_;
+    size_t key_len_ = 0;
+    bool identity_ = true;
+};
+
+// 标量实现，用于对比和验证
+void xor_key_stream_scalar(const unsigned char *src, unsigned char *dst, size_t n, const unsigned char *key,
+                           size_t key_len, size_t offset);
+
+#endif //ZHANGCHAO_XOR_CIPHER_H
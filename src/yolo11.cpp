@@ -1,200 +1,32 @@
 #include "yolo11.h"
-
-static std::tuple<cv::Mat, std::pair<double, double>, std::pair<double, double>>
-letterbox(cv::Mat im, cv::Size new_shape = cv::Size(640, 640),
-    cv::Scalar color = cv::Scalar(114, 114, 114),
-    bool auto_ = true, bool scaleFill = false, bool scaleup = true, int stride = 32) {
-    // Resize and pad image while meeting stride-multiple constraints
-    cv::Size shape = im.size();  // current shape [width, height] - Note: OpenCV size is width-first
-
-    if (new_shape.width == 0) new_shape.width = new_shape.height;
-    if (new_shape.height == 0) new_shape.height = new_shape.width;
-
-    // Scale ratio (new / old)
-    double r = std::min(new_shape.height / static_cast<double>(shape.height),
-        new_shape.width / static_cast<double>(shape.width));
-    if (!scaleup) {  // only scale down, do not scale up (for better val mAP)
-        r = std::min(r, 1.0);
-    }
-
-    // Compute padding
-    std::pair<double, double> ratio(r, r);  // width, height ratios
-    cv::Size new_unpad(static_cast<int>(std::round(shape.width * r)),
-        static_cast<int>(std::round(shape.height * r)));
-
-    double dw = new_shape.width - new_unpad.width;
-    double dh = new_shape.height - new_unpad.height;
-
-    if (auto_) {  // minimum rectangle
-        dw = std::fmod(dw, stride);
-        dh = std::fmod(dh, stride);
-    }
-    else if (scaleFill) {  // stretch
-        dw = 0.0;
-        dh = 0.0;
-        new_unpad = new_shape;
-        ratio = { new_shape.width / static_cast<double>(shape.width),
-                 new_shape.height / static_cast<double>(shape.height) };
-    }
-
-    dw /= 2.0;  // divide padding into 2 sides
-    dh /= 2.0;
-
-    if (shape != new_unpad) {  // resize
-        cv::resize(im, im, new_unpad, 0, 0, cv::INTER_LINEAR);
-    }
-
-    int top = static_cast<int>(std::round(dh - 0.1));
-    int bottom = static_cast<int>(std::round(dh + 0.1));
-    int left = static_cast<int>(std::round(dw - 0.1));
-    int right = static_cast<int>(std::round(dw + 0.1));
-
-    cv::copyMakeBorder(im, im, top, bottom, left, right, cv::BORDER_CONSTANT, color);
-
-    return std::make_tuple(im, ratio, std::make_pair(dw, dh));
-}
-
-static inline float sigmoid(float x)
-{
-    return 1.0f / (1.0f + expf(-x));
-}
-
-static float softmax(const float* src, float* dst, int length)
-{
-    float alpha = -FLT_MAX;
-    for (int c = 0; c < length; c++)
-    {
-        float score = src[c];
-        if (score > alpha)
-        {
-            alpha = score;
-        }
-    }
-
-    float denominator = 0;
-    float dis_sum = 0;
-    for (int i = 0; i < length; ++i)
-    {
-        dst[i] = expf(src[i] - alpha);
-        denominator += dst[i];
-    }
-    for (int i = 0; i < length; ++i)
-    {
-        dst[i] /= denominator;
-        dis_sum += i * dst[i];
-    }
-    return dis_sum;
-}
+#include "decoder.h"
 
 static float clamp(float val, float min = 0.f, float max = 1280.f)
 {
     return val > min ? (val < max ? val : max) : min;
 }
 
-static void generate_proposals(
-    int stride,
-    const ncnn::Mat& feat_blob,
-    const float prob_threshold,
-    std::vector<Object>& objects
-)
-{
-    const int reg_max = 16;
-    float dst[16];
-    const int num_w = feat_blob.w;
-    const int num_grid_y = feat_blob.c;
-    const int num_grid_x = feat_blob.h;
-
-    const int num_class = num_w - 4 * reg_max;
-
-    for (int i = 0; i < num_grid_y; i++)
-    {
-        for (int j = 0; j < num_grid_x; j++)
-        {
-
-            const float* matat = feat_blob.channel(i).row(j);
-
-            int class_index = 0;
-            float class_score = -FLT_MAX;
-            for (int c = 0; c < num_class; c++)
-            {
-                float score = matat[4 * reg_max + c];
-                if (sigmoid(score) > class_score)
-                {
-                    class_index = c;
-                    class_score = sigmoid(score);
-                }
-            }
-
-            if (class_score >= prob_threshold)
-            {
-
-                float x0 = j + 0.5f - softmax(matat, dst, 16);
-                float y0 = i + 0.5f - softmax(matat + 16, dst, 16);
-                float x1 = j + 0.5f + softmax(matat + 2 * 16, dst, 16);
-                float y1 = i + 0.5f + softmax(matat + 3 * 16, dst, 16);
-
-                x0 *= stride;
-                y0 *= stride;
-                x1 *= stride;
-                y1 *= stride;
-
-                Object obj;
-                obj.rect.x = x0;
-                obj.rect.y = y0;
-                obj.rect.width = x1 - x0;
-                obj.rect.height = y1 - y0;
-                obj.label = class_index;
-                obj.prob = class_score;
-                objects.push_back(obj);
-
-            }
-        }
-    }
-}
-
-static void non_max_suppression(
-    std::vector<Object>& proposals,
+// 把nms保留下来的框从网络输入尺度映射回原图
+static void scale_boxes(
+    const std::vector<Object>& proposals,
+    const std::vector<int>& keep,
     std::vector<Object>& results,
     int orin_h,
     int orin_w,
     float dh = 0,
     float dw = 0,
     float ratio_h = 1.0f,
-    float ratio_w = 1.0f,
-    float conf_thres = 0.25f,
-    float iou_thres = 0.65f
+    float ratio_w = 1.0f
 )
 {
     results.clear();
-    std::vector<cv::Rect> bboxes;
-    std::vector<float> scores;
-    std::vector<int> labels;
-    std::vector<int> indices;
-
-    for (auto& pro : proposals)
+    for (auto i : keep)
     {
-        bboxes.push_back(pro.rect);
-        scores.push_back(pro.prob);
-        labels.push_back(pro.label);
-    }
-
-    cv::dnn::NMSBoxes(
-        bboxes,
-        scores,
-        conf_thres,
-        iou_thres,
-        indices
-    );
-
-    for (auto i : indices)
-    {
-        auto& bbox = bboxes[i];
-        float x0 = bbox.x;
-        float y0 = bbox.y;
-        float x1 = bbox.x + bbox.width;
-        float y1 = bbox.y + bbox.height;
-        float& score = scores[i];
-        int& label = labels[i];
+        const Object& pro = proposals[i];
+        float x0 = pro.rect.x;
+        float y0 = pro.rect.y;
+        float x1 = pro.rect.x + pro.rect.width;
+        float y1 = pro.rect.y + pro.rect.height;
 
         x0 = (x0 - dw) / ratio_w;
         y0 = (y0 - dh) / ratio_h;
@@ -211,18 +43,20 @@ static void non_max_suppression(
         obj.rect.y = y0;
         obj.rect.width = x1 - x0;
         obj.rect.height = y1 - y0;
-        obj.prob = score;
-        obj.label = label;
+        obj.prob = pro.prob;
+        obj.label = pro.label;
         results.push_back(obj);
     }
 }
 
-bool Yolov11::load_model(const char* param_path, const char* bin_path, int target_size, bool use_gpu,
-    unsigned char key1, unsigned char key2)
+void Yolov11::init_net(bool use_gpu)
 {
     net_.clear();
+    model_file_.close();
+    bundle_.close();
     blob_pool_allocator_.clear();
     workspace_pool_allocator_.clear();
+    metadata_ = ModelMetadata();
 
     ncnn::set_cpu_powersave(2);
     ncnn::set_omp_num_threads(ncnn::get_big_cpu_count());
@@ -230,12 +64,29 @@ bool Yolov11::load_model(const char* param_path, const char* bin_path, int targe
     net_.opt = ncnn::Option();
 
 #if NCNN_VULKAN
-    net_.opt.use_vulkan_compute = ues_gpu;
+    net_.opt.use_vulkan_compute = use_gpu;
 #endif
 
     net_.opt.num_threads = ncnn::get_big_cpu_count();
     net_.opt.blob_allocator = &blob_pool_allocator_;
     net_.opt.workspace_allocator = &workspace_pool_allocator_;
+}
+
+bool Yolov11::load_model(const char* param_path, const char* bin_path, int target_size, bool use_gpu,
+    unsigned char key1, unsigned char key2, bool use_mmap)
+{
+    init_net(use_gpu);
+
+    if (use_mmap)
+    {
+        if (load_model_mmap(net_, param_path, bin_path, key1, key2, model_file_) != 0)
+        {
+            std::cerr << "fail to load model!" << std::endl;
+            return false;
+        }
+        this->input_size_ = target_size;
+        return true;
+    }
 
     auto ret = net_.load_param(param_path);
     if (ret != 0)
@@ -255,119 +106,181 @@ bool Yolov11::load_model(const char* param_path, const char* bin_path, int targe
     return true;
 }
 
+bool Yolov11::load_bundle(const char* bundle_path, bool use_gpu, const unsigned char* key, size_t key_len,
+    int target_size)
+{
+    init_net(use_gpu);
+
+    if (!bundle_.open(bundle_path))
+    {
+        std::cerr << "fail to open bundle!" << std::endl;
+        return false;
+    }
+    ModelMetadata metadata;
+    if (!bundle_.read_metadata(metadata, key, key_len))
+    {
+        std::cerr << "fail to read bundle metadata!" << std::endl;
+        bundle_.close();
+        return false;
+    }
+    if (bundle_.load_net(net_, key, key_len) != 0)
+    {
+        std::cerr << "fail to load model!" << std::endl;
+        net_.clear();
+        bundle_.close();
+        return false;
+    }
+
+    metadata_ = std::move(metadata);
+    this->input_size_ = target_size > 0 ? target_size : std::max(metadata_.input_width, metadata_.input_height);
+    return true;
+}
+
+const std::vector<std::string>& Yolov11::class_names() const
+{
+    return metadata_.class_names;
+}
+
 bool Yolov11::detect(const cv::Mat& bgr, std::vector<Object>& objects, float prob_threshold,
     float nms_threshold, bool is_video)
 {
     objects.clear();
-    
-    int img_w = bgr.cols;
-    int img_h = bgr.rows;
-
-    int w = img_w;
-    int h = img_h;
-    float scale = 1.f;
-    if (w > h)
-    {
-        scale = (float)this->input_size_ / w;
-        w = this->input_size_;
-        h = h * scale;
-    }
-    else
+
+    preprocess(bgr, context_, net_.opt.num_threads);
+
+    if (!forward(context_))
     {
-        scale = (float)this->input_size_ / h;
-        h = this->input_size_;
-        w = w * scale;
+        return false;
     }
 
-    // bgr2rgb
-    ncnn::Mat in = ncnn::Mat::from_pixels_resize(bgr.data, ncnn::Mat::PIXEL_BGR2RGB, img_w, img_h, w, h);
-
-    // letter box
-    int wpad = this->input_size_ - w;
-    int hpad = this->input_size_ - h;
-    int top = hpad / 2;
-    int bottom = hpad - hpad / 2;
-    int left = wpad / 2;
-    int right = wpad - wpad / 2;
-    ncnn::Mat in_pad;
-    ncnn::copy_make_border(in,
-        in_pad,
-        top,
-        bottom,
-        left,
-        right,
-        ncnn::BORDER_CONSTANT,
-        114.f);
-
-    // normalize
-    const float norm_vals[3] = { 1 / 255.f, 1 / 255.f, 1 / 255.f };
-    in_pad.substract_mean_normalize(0, norm_vals);
+    postprocess(context_, objects, prob_threshold, nms_threshold);
 
-    ncnn::Extractor ex = net_.create_extractor();
-    ex.input("in0", in_pad);
-    std::vector<Object> proposals;
+    return true;
+}
 
-    // stride 8 
+bool Yolov11::detect_batch(const std::vector<cv::Mat>& bgrs, std::vector<std::vector<Object>>& objects,
+    float prob_threshold, float nms_threshold)
+{
+    const int batch = (int)bgrs.size();
+    objects.resize(batch);
+    if (batch == 0)
     {
-        ncnn::Mat out;
-        ex.extract("out0", out);
-        std::vector<Object> objects8;
-        generate_proposals(8, out, prob_threshold, objects8);
-        proposals.insert(proposals.end(), objects8.begin(), objects8.end());
+        return true;
     }
 
-    // stride 16 
+    while ((int)batch_contexts_.size() < batch)
     {
-        ncnn::Mat out;
-        ex.extract("out1", out);
-        std::vector<Object> objects16;
-        generate_proposals(16, out, prob_threshold, objects16);
-        proposals.insert(proposals.end(), objects16.begin(), objects16.end());
+        batch_contexts_.emplace_back(new DetectContext());
+        batch_blob_allocators_.emplace_back(new ncnn::UnlockedPoolAllocator());
+        batch_workspace_allocators_.emplace_back(new ncnn::UnlockedPoolAllocator());
+        batch_blob_allocators_.back()->set_size_compare_ratio(0.f);
+        batch_workspace_allocators_.back()->set_size_compare_ratio(0.f);
     }
 
-    // stride 32 
+    // 常驻的线程池，线程数等于net的线程数，多次调用之间复用，不再每次创建和回收线程
+    const int total_threads = std::max(1, net_.opt.num_threads);
+    if (!batch_pool_ || batch_pool_->num_threads() != total_threads)
     {
-        ncnn::Mat out;
-        ex.extract("out2", out);
-        std::vector<Object> objects32;
-        generate_proposals(32, out, prob_threshold, objects32);
-        proposals.insert(proposals.end(), objects32.begin(), objects32.end());
+        batch_pool_.reset(new WorkStealingPool(total_threads));
     }
 
-    for (auto& pro : proposals)
+    // 同时处理的帧数不超过池的线程数，线程按帧平分，总线程数不超过net_.opt.num_threads
+    const int num_threads = std::max(1, total_threads / std::min(batch, total_threads));
+    std::vector<char> ok(batch, 0);
+    batch_pool_->parallel_for(batch, [&](int i)
     {
-        float x0 = pro.rect.x;
-        float y0 = pro.rect.y;
-        float x1 = pro.rect.x + pro.rect.width;
-        float y1 = pro.rect.y + pro.rect.height;
-        float& score = pro.prob;
-        int& label = pro.label;
+        DetectContext& ctx = *batch_contexts_[i];
+        objects[i].clear();
+        preprocess(bgrs[i], ctx, num_threads);
+        if (forward(ctx, batch_blob_allocators_[i].get(), batch_workspace_allocators_[i].get(), num_threads))
+        {
+            postprocess(ctx, objects[i], prob_threshold, nms_threshold);
+            ok[i] = 1;
+        }
+        for (auto& out : ctx.outs)
+        {
+            out.release();
+        }
+    });
 
-        x0 = (x0 - (wpad / 2)) / scale;
-        y0 = (y0 - (hpad / 2)) / scale;
-        x1 = (x1 - (wpad / 2)) / scale;
-        y1 = (y1 - (hpad / 2)) / scale;
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
 
-        x0 = clamp(x0, 0.f, img_w);
-        y0 = clamp(y0, 0.f, img_h);
-        x1 = clamp(x1, 0.f, img_w);
-        y1 = clamp(y1, 0.f, img_h);
+void Yolov11::preprocess(const cv::Mat& bgr, DetectContext& ctx, int num_threads) const
+{
+    ctx.img_w = bgr.cols;
+    ctx.img_h = bgr.rows;
 
-        Object obj;
-        obj.rect.x = x0;
-        obj.rect.y = y0;
-        obj.rect.width = x1 - x0;
-        obj.rect.height = y1 - y0;
-        obj.prob = score;
-        obj.label = label;
-        objects.push_back(obj);
+    // letter box，动态尺寸模式下只填充到最大stride(32)的整数倍，16:9的画面输入640x384即可
+    const int max_stride = *std::max_element(metadata_.strides.begin(), metadata_.strides.end());
+    ctx.info = letterbox(ctx.img_w, ctx.img_h, this->input_size_, this->input_size_, this->dynamic_shape_, true,
+        max_stride);
+
+    // resize + bgr2rgb + pad + normalize 一次完成，写入复用的ctx.in
+    ctx.preprocessor.run(bgr.data, ctx.img_w, ctx.img_h, (int)bgr.step, ctx.info, ctx.in, 114.f, num_threads);
+}
+
+bool Yolov11::forward(DetectContext& ctx, ncnn::Allocator* blob_allocator,
+    ncnn::Allocator* workspace_allocator, int num_threads) const
+{
+    ncnn::Extractor ex = net_.create_extractor();
+    if (blob_allocator)
+    {
+        ex.set_blob_allocator(blob_allocator);
+    }
+    if (workspace_allocator)
+    {
+        ex.set_workspace_allocator(workspace_allocator);
+    }
+    if (num_threads > 0)
+    {
+        ex.set_num_threads(num_threads);
+    }
+
+    const std::vector<std::string>& out_names = metadata_.output_names;
+    ctx.outs.resize(out_names.size());
+
+    ex.input(metadata_.input_name.c_str(), ctx.in);
+    for (size_t i = 0; i < out_names.size(); i++)
+    {
+        if (ex.extract(out_names[i].c_str(), ctx.outs[i]) != 0)
+        {
+            std::cerr << "fail to extract " << out_names[i] << "!" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Yolov11::postprocess(DetectContext& ctx, std::vector<Object>& objects, float prob_threshold,
+    float nms_threshold) const
+{
+    std::vector<Object>& proposals = ctx.proposals;
+    proposals.clear();
+
+    // 阈值换算到logit空间，解码时只对通过的格子做sigmoid和DFL
+    const float logit_threshold = inverse_sigmoid(prob_threshold);
+    const int* class_ids = class_filter_.empty() ? nullptr : class_filter_.data();
+    const int num_class_ids = (int)class_filter_.size();
+
+    // 默认stride 8 / 16 / 32；输出宽度放不下4*reg_max的框分布时说明与元数据不符，跳过
+    // 过滤条件中没有合法的类别id时不解码，结果为空
+    for (size_t i = 0; i < ctx.outs.size() && !class_filter_none_; i++)
+    {
+        if (ctx.outs[i].w <= 4 * metadata_.reg_max)
+        {
+            continue;
+        }
+        decode_proposals(metadata_.strides[i], ctx.outs[i], logit_threshold, proposals, metadata_.reg_max,
+            class_ids, num_class_ids);
     }
 
-    non_max_suppression(proposals, objects,
-        img_h, img_w, hpad / 2, wpad / 2,
-        scale, scale, prob_threshold, nms_threshold);
+    ctx.nms.set_options(nms_options_);
+    ctx.nms.run(proposals, nms_threshold, ctx.keep);
 
-    return 0;
+    scale_boxes(proposals, ctx.keep, objects,
+        ctx.img_h, ctx.img_w, ctx.info.top, ctx.info.left,
+        ctx.info.scale, ctx.info.scale);
 }
 
 Yolov11::Yolov11()
@@ -376,6 +289,32 @@ Yolov11::Yolov11()
     workspace_pool_allocator_.set_size_compare_ratio(0.f);
 }
 
+void Yolov11::set_dynamic_shape(bool enable)
+{
+    dynamic_shape_ = enable;
+}
+
+void Yolov11::set_class_filter(const std::vector<int>& filter)
+{
+    class_filter_.clear();
+    // 负数id不对应任何类别，全部无效时什么都不保留，而不是退化成不过滤
+    for (int id : filter)
+    {
+        if (id >= 0)
+        {
+            class_filter_.push_back(id);
+        }
+    }
+    std::sort(class_filter_.begin(), class_filter_.end());
+    class_filter_.erase(std::unique(class_filter_.begin(), class_filter_.end()), class_filter_.end());
+    class_filter_none_ = !filter.empty() && class_filter_.empty();
+}
+
+void Yolov11::set_nms_options(const NmsOptions& options)
+{
+    nms_options_ = options;
+}
+
 Yolov11::~Yolov11()
 {
     net_.clear();
@@ -8,11 +8,32 @@
 #ifndef ZHANGCHAO_YOLOV5_VIDEO_H
 #define ZHANGCHAO_YOLOV5_VIDEO_H
 
+#include <memory>
 #include <string>
 //#include <android/asset_manager.h>
 #include <ncnn/net.h>
 #include <ncnn/cpu.h>
 #include "common.h"
+#include "model_bundle.h"
+#include "model_loader.h"
+#include "nms.h"
+#include "preprocess.h"
+#include "work_stealing_pool.h"
+
+/**
+ * 单帧检测的中间数据和复用的缓冲区，并发推理时每个工作单元各自持有一份
+ */
+struct DetectContext {
+    int img_w = 0;
+    int img_h = 0;
+    LetterboxInfo info;
+    LetterboxPreprocessor preprocessor;
+    ncnn::Mat in;       // 网络输入
+    std::vector<ncnn::Mat> outs;  // 与模型的输出一一对应，默认out0/out1/out2
+    NmsEngine nms;
+    std::vector<Object> proposals;
+    std::vector<int> keep;
+};
 
 class Yolov11 {
 public:
@@ -20,18 +41,86 @@ public:
 
     ~Yolov11();
 
+    /**
+     * @param use_mmap 映射模型文件加载，未加密的权重直接引用映射的页，多个进程共享page cache
+     */
     bool load_model(const char* param_path, const char* bin_path, int target_size, bool use_gpu,
-        unsigned char key1 = 0, unsigned char key2 = 0);
+        unsigned char key1 = 0, unsigned char key2 = 0, bool use_mmap = false);
+
+    /**
+     * 从模型包加载，输入输出名、输入尺寸、strides、reg_max和类别名取自包中的元数据
+     * @param key 加密段的密钥，与MyEncryptedDataReader相同
+     * @param target_size 为0时使用元数据中的输入尺寸
+     */
+    bool load_bundle(const char* bundle_path, bool use_gpu, const unsigned char* key = nullptr, size_t key_len = 0,
+        int target_size = 0);
+
+    // 模型包中的类别名，load_model加载时为空
+    const std::vector<std::string>& class_names() const;
 
     bool detect(const cv::Mat& bgr, std::vector<Object>& objects, float prob_threshold = 0.25f,
         float nms_threshold = 0.45f, bool is_video = false);
 
+    /**
+     * 批量检测：K帧各自letterbox后在常驻线程池中并发推理，每帧的extractor分到 总线程数/min(K, 总线程数) 个线程，
+     * 避免K次单独推理各自做一遍线程派发和小矩阵计算，输出按帧拆分后分别解码
+     * @param bgrs K帧bgr图像
+     * @param objects 每帧的检测结果，大小为K
+     */
+    bool detect_batch(const std::vector<cv::Mat>& bgrs, std::vector<std::vector<Object>>& objects,
+        float prob_threshold = 0.25f, float nms_threshold = 0.45f);
+
+    /**
+     * 以下三个阶段组成detect，均为const，不同的DetectContext可以在不同线程中同时调用
+     */
+    // letterbox预处理，结果写入ctx.in
+    void preprocess(const cv::Mat& bgr, DetectContext& ctx, int num_threads = 1) const;
+
+    // 网络推理，结果写入ctx.outs，allocator为空时使用net的默认设置
+    bool forward(DetectContext& ctx, ncnn::Allocator* blob_allocator = nullptr,
+        ncnn::Allocator* workspace_allocator = nullptr, int num_threads = 0) const;
+
+    // 解码 + nms + 映射回原图
+    void postprocess(DetectContext& ctx, std::vector<Object>& objects, float prob_threshold = 0.25f,
+        float nms_threshold = 0.45f) const;
+
+    /**
+     * 动态尺寸模式：输入只填充到32的整数倍（如16:9画面为640x384），而不是input_size的正方形
+     * 需要用dynamic=True导出的模型，固定尺寸导出的模型中attention的Reshape写死了20x20
+     */
+    void set_dynamic_shape(bool enable);
+
+    void set_nms_options(const NmsOptions& options);
+
+    /**
+     * 设置需要保留的类别，其他类别在解码时直接跳过
+     * @param filter 类别id，空对象不过滤；负数和超出模型类别数的id被忽略，
+     *               非空但没有合法id时不保留任何目标
+     */
+    void set_class_filter(const std::vector<int>& filter);
+
 private:
+    void init_net(bool use_gpu);
+
+    // 映射的bin文件或模型包，net_引用其中的权重，要在net_之后析构
+    MappedFile model_file_;
+    ModelBundle bundle_;
     ncnn::Net net_;
     int input_size_{};
+    ModelMetadata metadata_; // 输入输出名、strides和reg_max，load_model时为默认值
+    bool dynamic_shape_ = false;
     std::vector<cv::Mat> history_; // 用于存储历史帧
     ncnn::UnlockedPoolAllocator blob_pool_allocator_;
     ncnn::PoolAllocator workspace_pool_allocator_;
+    NmsOptions nms_options_;
+    std::vector<int> class_filter_; // 升序去重后的非负类别id，空表示不过滤
+    bool class_filter_none_ = false; // filter非空但没有合法id，不保留任何目标
+    DetectContext context_; // detect使用的缓冲区，多帧复用
+    // detect_batch每个槽位的缓冲区和allocator，槽位在一次调用中只被一个线程使用
+    std::vector<std::unique_ptr<DetectContext>> batch_contexts_;
+    std::vector<std::unique_ptr<ncnn::UnlockedPoolAllocator>> batch_blob_allocators_;
+    std::vector<std::unique_ptr<ncnn::UnlockedPoolAllocator>> batch_workspace_allocators_;
+    std::unique_ptr<WorkStealingPool> batch_pool_; // detect_batch的工作线程，第一次调用时创建
 };
 
 #endif //ZHANGCHAO_YOLOV5_VIDEO_H
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <random>
+#include "yolo11.h"
+
+// 吞吐量随batch大小的变化，模型路径与main.cpp一致
+int main(int argc, char** argv)
+{
+    const std::string yolo_param_path = argc > 1 ? argv[1] : "../assets/yolo11n_ncnn_model/model.ncnn.param";
+    const std::string yolo_bin_path = argc > 2 ? argv[2] : "../assets/yolo11n_ncnn_model/model.ncnn.bin";
+    const int num_frames = argc > 3 ? atoi(argv[3]) : 64;
+
+    Yolov11 model;
+    if (!model.load_model(yolo_param_path.c_str(), yolo_bin_path.c_str(), 640, false))
+    {
+        std::cerr << "load model failed" << std::endl;
+        return -1;
+    }
+
+    // 模拟1080p的视频帧
+    std::mt19937 rng(0);
+    std::vector<cv::Mat> frames;
+    for (int i = 0; i < 8; i++)
+    {
+        cv::Mat bgr(1080, 1920, CV_8UC3);
+        for (int y = 0; y < bgr.rows; y++)
+        {
+            unsigned char* p = bgr.ptr(y);
+            for (int x = 0; x < bgr.cols * 3; x++)
+            {
+                p[x] = (unsigned char)(rng() & 0xff);
+            }
+        }
+        frames.push_back(bgr);
+    }
+
+    // 预热
+    std::vector<Object> objects;
+    model.detect(frames[0], objects);
+
+    const int batch_sizes[] = { 1, 2, 4, 8 };
+    for (int batch : batch_sizes)
+    {
+        std::vector<cv::Mat> bgrs(frames.begin(), frames.begin() + batch);
+        std::vector<std::vector<Object>> batch_objects;
+        model.detect_batch(bgrs, batch_objects);
+
+        const int rounds = std::max(1, num_frames / batch);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            model.detect_batch(bgrs, batch_objects);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        double fps = rounds * batch / seconds;
+        std::cout << "batch " << batch << ": " << fps << " frames/s, " << seconds * 1000.0 / rounds
+            << " ms per batch" << std::endl;
+    }
+
+    return 0;
+}
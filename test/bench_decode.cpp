@@ -0,0 +1,155 @@
+#include <cfloat>
+#include <chrono>
+#include <random>
+#include "decoder.h"
+
+// 原来的逐类sigmoid解码，作为对比基准
+static inline float sigmoid(float x)
+{
+    return 1.0f / (1.0f + expf(-x));
+}
+
+static float softmax(const float* src, float* dst, int length)
+{
+    float alpha = -FLT_MAX;
+    for (int c = 0; c < length; c++)
+    {
+        if (src[c] > alpha)
+        {
+            alpha = src[c];
+        }
+    }
+
+    float denominator = 0;
+    float dis_sum = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        dst[i] = expf(src[i] - alpha);
+        denominator += dst[i];
+    }
+    for (int i = 0; i < length; ++i)
+    {
+        dst[i] /= denominator;
+        dis_sum += i * dst[i];
+    }
+    return dis_sum;
+}
+
+static void generate_proposals(int stride, const ncnn::Mat& feat_blob, const float prob_threshold,
+    std::vector<Object>& objects)
+{
+    const int reg_max = 16;
+    float dst[16];
+    const int num_w = feat_blob.w;
+    const int num_grid_y = feat_blob.c;
+    const int num_grid_x = feat_blob.h;
+
+    const int num_class = num_w - 4 * reg_max;
+
+    for (int i = 0; i < num_grid_y; i++)
+    {
+        for (int j = 0; j < num_grid_x; j++)
+        {
+            const float* matat = feat_blob.channel(i).row(j);
+
+            int class_index = 0;
+            float class_score = -FLT_MAX;
+            for (int c = 0; c < num_class; c++)
+            {
+                float score = matat[4 * reg_max + c];
+                if (sigmoid(score) > class_score)
+                {
+                    class_index = c;
+                    class_score = sigmoid(score);
+                }
+            }
+
+            if (class_score >= prob_threshold)
+            {
+                float x0 = j + 0.5f - softmax(matat, dst, 16);
+                float y0 = i + 0.5f - softmax(matat + 16, dst, 16);
+                float x1 = j + 0.5f + softmax(matat + 2 * 16, dst, 16);
+                float y1 = i + 0.5f + softmax(matat + 3 * 16, dst, 16);
+
+                Object obj;
+                obj.rect.x = x0 * stride;
+                obj.rect.y = y0 * stride;
+                obj.rect.width = (x1 - x0) * stride;
+                obj.rect.height = (y1 - y0) * stride;
+                obj.label = class_index;
+                obj.prob = class_score;
+                objects.push_back(obj);
+            }
+        }
+    }
+}
+
+// 模拟检测头输出：绝大多数格子的类别logit远小于0，少量格子有目标
+static ncnn::Mat make_feat(int grid, std::mt19937& rng)
+{
+    const int num_w = 4 * 16 + 80;
+    ncnn::Mat feat(num_w, grid, grid);
+    std::normal_distribution<float> background(-7.f, 1.5f);
+    std::normal_distribution<float> box(0.f, 2.f);
+    std::uniform_real_distribution<float> u(0.f, 1.f);
+    for (int i = 0; i < grid; i++)
+    {
+        for (int j = 0; j < grid; j++)
+        {
+            float* p = feat.channel(i).row(j);
+            for (int k = 0; k < 64; k++)
+            {
+                p[k] = box(rng);
+            }
+            for (int c = 0; c < 80; c++)
+            {
+                p[64 + c] = background(rng);
+            }
+            if (u(rng) < 0.01f)
+            {
+                p[64 + (int)(u(rng) * 80)] = u(rng) * 4.f - 1.f;
+            }
+        }
+    }
+    return feat;
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    const float prob_threshold = 0.25f;
+    const char* names[3] = { "out0", "out1", "out2" };
+    const int strides[3] = { 8, 16, 32 };
+
+    std::mt19937 rng(0);
+    for (int k = 0; k < 3; k++)
+    {
+        ncnn::Mat feat = make_feat(640 / strides[k], rng);
+        std::vector<Object> before, after;
+        before.reserve(8400);
+        after.reserve(8400);
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < iterations; it++)
+        {
+            before.clear();
+            generate_proposals(strides[k], feat, prob_threshold, before);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        const float logit_threshold = inverse_sigmoid(prob_threshold);
+        for (int it = 0; it < iterations; it++)
+        {
+            after.clear();
+            decode_proposals(strides[k], feat, logit_threshold, after);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        double us_before = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() / 1000.0 / iterations;
+        double us_after = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1000.0 / iterations;
+        std::cout << names[k] << " stride " << strides[k] << ": before " << us_before << " us, after " << us_after
+            << " us, speedup " << us_before / us_after << "x, proposals " << before.size() << "/" << after.size()
+            << std::endl;
+    }
+
+    return 0;
+}
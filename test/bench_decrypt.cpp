@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "xor_cipher.h"
+
+// 原来的实现：fread到目标缓冲区后逐字节异或
+static size_t legacy_read(FILE* fp, unsigned char key, unsigned char* buf, size_t size)
+{
+    size_t nread = fread(buf, 1, size, fp);
+    for (size_t i = 0; i < nread; i++)
+    {
+        buf[i] ^= key;
+    }
+    return nread;
+}
+
+// ncnn按层读取权重，每次读取的大小不同，这里用固定序列模拟
+static size_t chunk_size(size_t i)
+{
+    static const size_t sizes[] = { 64, 4096, 1 << 20, 576, 36864, 256 << 10, 12, 147456 };
+    return sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+}
+
+static bool write_file(const std::string& path, const std::vector<unsigned char>& data)
+{
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    fclose(fp);
+    return ok;
+}
+
+static double seconds_since(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// 用reader按块读出整个文件，返回耗时，结果写入out
+template <typename Read>
+static double read_all(std::vector<unsigned char>& out, Read read)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t offset = 0;
+    for (size_t i = 0; offset < out.size(); i++)
+    {
+        size_t n = read(out.data() + offset, std::min(chunk_size(i), out.size() - offset));
+        if (n == 0)
+        {
+            break;
+        }
+        offset += n;
+    }
+    return seconds_since(start);
+}
+
+// 加密模型的解密吞吐：原来的fread+逐字节异或与映射+向量化异或对比，单字节密钥和多字节密钥各测一次
+// 用法: bench_decrypt [大小MB] [临时文件]
+int main(int argc, char** argv)
+{
+    const size_t mb = argc > 1 ? (size_t)atol(argv[1]) : 100;
+    const std::string path = argc > 2 ? argv[2] : "bench_decrypt.bin";
+    const size_t size = mb << 20;
+    const double gb = size / 1e9;
+
+    std::vector<unsigned char> plain(size);
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        plain[i] = (unsigned char)(seed >> 16);
+    }
+
+    printf("size %zu MB, isa %s\n", mb, XorKeyStream::isa_name());
+
+    // 纯内存中的异或吞吐
+    {
+        const unsigned char key[] = { 0x5a, 0x13, 0xc7, 0x21, 0x9e, 0x44, 0x08, 0xb1, 0x7f, 0x36, 0xe2, 0x6d, 0x90 };
+        XorKeyStream cipher(key, sizeof(key));
+        std::vector<unsigned char> a(size), b(size);
+        auto start = std::chrono::high_resolution_clock::now();
+        xor_key_stream_scalar(plain.data(), a.data(), size, key, sizeof(key), 0);
+        double t_scalar = seconds_since(start);
+        start = std::chrono::high_resolution_clock::now();
+        cipher.apply(plain.data(), b.data(), size, 0);
+        double t_simd = seconds_since(start);
+        printf("in-memory xor  scalar %6.2f GB/s   %-6s %6.2f GB/s   %s\n", gb / t_scalar, XorKeyStream::isa_name(),
+            gb / t_simd, a == b ? "match" : "MISMATCH");
+        if (a != b)
+        {
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    const unsigned char single_key = 0x5a;
+    const unsigned char multi_key[] = { 0x5a, 0x13, 0xc7, 0x21, 0x9e, 0x44, 0x08, 0xb1, 0x7f, 0x36, 0xe2, 0x6d, 0x90 };
+    for (int multi = 0; multi < 2; multi++)
+    {
+        const unsigned char* key = multi ? multi_key : &single_key;
+        const size_t key_len = multi ? sizeof(multi_key) : 1;
+
+        std::vector<unsigned char> encrypted(size);
+        xor_key_stream_scalar(plain.data(), encrypted.data(), size, key, key_len, 0);
+        if (!write_file(path, encrypted))
+        {
+            std::cerr << "write " << path << " failed" << std::endl;
+            return 1;
+        }
+        encrypted.clear();
+        encrypted.shrink_to_fit();
+
+        std::vector<unsigned char> out(size);
+        double t_old = -1;
+        if (!multi)
+        {
+            // 原来的读取器只支持单字节密钥
+            FILE* fp = fopen(path.c_str(), "rb");
+            t_old = read_all(out, [&](unsigned char* buf, size_t n) { return legacy_read(fp, single_key, buf, n); });
+            fclose(fp);
+            failures += out != plain;
+            std::fill(out.begin(), out.end(), 0);
+        }
+
+        double t_new;
+        {
+            MyEncryptedDataReader reader(path.c_str(), key, key_len);
+            t_new = read_all(out, [&](unsigned char* buf, size_t n) { return reader.read(buf, n); });
+        }
+        bool ok = out == plain;
+        failures += !ok;
+
+        if (t_old > 0)
+        {
+            printf("%2zu-byte key    fread+xor %6.2f GB/s   mmap+%-6s %6.2f GB/s   %s\n", key_len, gb / t_old,
+                XorKeyStream::isa_name(), gb / t_new, ok ? "match" : "MISMATCH");
+        }
+        else
+        {
+            printf("%2zu-byte key    %-21s   mmap+%-6s %6.2f GB/s   %s\n", key_len, "", XorKeyStream::isa_name(),
+                gb / t_new, ok ? "match" : "MISMATCH");
+        }
+    }
+    remove(path.c_str());
+
+    std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+    return failures != 0;
+}
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "byte_track/lapjv.h"
+#include "byte_track/lapSolver.h"
+
+// 原来BYTETracker::lapjv的做法：扩展成 (rows+cols) 的方阵，填充cost_limit/2后调用lapjv_internal
+static double lapjv_extended(const std::vector<float>& cost, int rows, int cols, float cost_limit,
+    std::vector<int>& rowsol, std::vector<int>& colsol)
+{
+    const int n = rows + cols;
+    std::vector<double> extended((size_t)n * n);
+    std::vector<double*> ptrs(n);
+    for (int i = 0; i < n; i++)
+    {
+        ptrs[i] = &extended[(size_t)i * n];
+        for (int j = 0; j < n; j++)
+        {
+            if (i < rows && j < cols)
+            {
+                ptrs[i][j] = cost[(size_t)i * cols + j];
+            }
+            else if (i >= rows && j >= cols)
+            {
+                ptrs[i][j] = 0;
+            }
+            else
+            {
+                ptrs[i][j] = (float)(cost_limit / 2.0);
+            }
+        }
+    }
+
+    std::vector<int> x(n), y(n);
+    lapjv_internal(n, ptrs.data(), x.data(), y.data());
+
+    double opt = 0;
+    rowsol.assign(rows, -1);
+    colsol.assign(cols, -1);
+    for (int i = 0; i < rows; i++)
+    {
+        if (x[i] < cols)
+        {
+            rowsol[i] = x[i];
+            colsol[x[i]] = i;
+            opt += cost[(size_t)i * cols + x[i]];
+        }
+    }
+    return opt;
+}
+
+// 均匀分布的随机代价
+static void random_cost(std::mt19937& rng, int rows, int cols, std::vector<float>& cost)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    cost.resize((size_t)rows * cols);
+    for (size_t i = 0; i < cost.size(); i++)
+    {
+        cost[i] = uniform(rng);
+    }
+}
+
+// 模拟跟踪场景的1-IoU矩阵：检测框为轨迹框加抖动，另有少量漏检和新目标，大部分元素为1
+static void iou_cost(std::mt19937& rng, int rows, int cols, std::vector<float>& cost)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    const float side = std::sqrt((float)std::max(rows, cols)) * 80.f;
+    std::vector<float> a((size_t)rows * 4), b((size_t)cols * 4);
+    for (int i = 0; i < rows; i++)
+    {
+        a[i * 4 + 0] = uniform(rng) * side;
+        a[i * 4 + 1] = uniform(rng) * side;
+        a[i * 4 + 2] = a[i * 4 + 0] + 30.f + uniform(rng) * 30.f;
+        a[i * 4 + 3] = a[i * 4 + 1] + 60.f + uniform(rng) * 60.f;
+    }
+    for (int j = 0; j < cols; j++)
+    {
+        if (j < rows && uniform(rng) < 0.9f)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                b[j * 4 + k] = a[j * 4 + k] + (uniform(rng) - 0.5f) * 10.f;
+            }
+        }
+        else
+        {
+            b[j * 4 + 0] = uniform(rng) * side;
+            b[j * 4 + 1] = uniform(rng) * side;
+            b[j * 4 + 2] = b[j * 4 + 0] + 30.f + uniform(rng) * 30.f;
+            b[j * 4 + 3] = b[j * 4 + 1] + 60.f + uniform(rng) * 60.f;
+        }
+    }
+
+    cost.resize((size_t)rows * cols);
+    for (int i = 0; i < rows; i++)
+    {
+        const float* p = &a[i * 4];
+        for (int j = 0; j < cols; j++)
+        {
+            const float* q = &b[j * 4];
+            float iw = std::min(p[2], q[2]) - std::max(p[0], q[0]) + 1;
+            float ih = std::min(p[3], q[3]) - std::max(p[1], q[1]) + 1;
+            float iou = 0.f;
+            if (iw > 0 && ih > 0)
+            {
+                float ua = (p[2] - p[0] + 1) * (p[3] - p[1] + 1) + (q[2] - q[0] + 1) * (q[3] - q[1] + 1) - iw * ih;
+                iou = iw * ih / ua;
+            }
+            cost[(size_t)i * cols + j] = 1.f - iou;
+        }
+    }
+}
+
+template<typename Func>
+static double time_ms(Func func, int rounds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        func();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / rounds;
+}
+
+// LapSolver与lapjv.cpp在随机矩阵和稀疏IoU矩阵上的耗时对比，两者的最优代价应当一致
+int main(int argc, char** argv)
+{
+    const int max_size = argc > 1 ? atoi(argv[1]) : 2000;
+    const int sizes[] = { 10, 50, 100, 200, 500, 1000, 2000 };
+    const float cost_limit = 0.8f;
+
+    std::mt19937 rng(0);
+    LapSolver solver;
+    std::vector<float> cost;
+    std::vector<int> rowsol, colsol;
+    int failures = 0;
+
+    for (int scene = 0; scene < 2; scene++)
+    {
+        std::cout << (scene == 0 ? "random costs" : "sparse iou costs") << std::endl;
+        for (int size : sizes)
+        {
+            if (size > max_size)
+            {
+                break;
+            }
+            const int rows = size;
+            const int cols = size + size / 10; // 检测数略多于轨迹数
+            if (scene == 0)
+            {
+                random_cost(rng, rows, cols, cost);
+            }
+            else
+            {
+                iou_cost(rng, rows, cols, cost);
+            }
+
+            const int rounds = size <= 100 ? 50 : (size <= 500 ? 3 : 1);
+            double ref_ms = time_ms([&]() { lapjv_extended(cost, rows, cols, cost_limit, rowsol, colsol); }, rounds);
+            double ms = time_ms([&]() { solver.solve(cost.data(), rows, cols, rowsol, colsol, cost_limit); }, rounds);
+
+            // 两种解法匹配数可能不同，比较 sum(c - limit)，即扩展问题的目标值
+            double ref_obj = 0, obj = 0;
+            {
+                std::vector<int> ref_rowsol, ref_colsol;
+                lapjv_extended(cost, rows, cols, cost_limit, ref_rowsol, ref_colsol);
+                for (int i = 0; i < rows; i++)
+                {
+                    if (ref_rowsol[i] >= 0)
+                    {
+                        ref_obj += cost[(size_t)i * cols + ref_rowsol[i]] - cost_limit;
+                    }
+                    if (rowsol[i] >= 0)
+                    {
+                        obj += cost[(size_t)i * cols + rowsol[i]] - cost_limit;
+                    }
+                }
+            }
+            const bool same = std::fabs(ref_obj - obj) < 1e-3 * std::max(1.0, std::fabs(ref_obj));
+            if (!same)
+            {
+                failures++;
+            }
+
+            std::cout << "  " << rows << "x" << cols << ": lapjv " << ref_ms << " ms, LapSolver " << ms << " ms ("
+                << ref_ms / ms << "x), objective " << ref_obj << " / " << obj << (same ? "" : "  MISMATCH")
+                << std::endl;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
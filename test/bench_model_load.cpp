@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "yolo11.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 把文件从page cache中清出去，模拟冷启动；页面被其它进程映射时系统可能不会丢弃
+static void drop_page_cache(const std::string& path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+// /proc/self/status中的内存项，单位KB；RssAnon为进程私有的匿名内存，RssFile为映射文件的页（可与其它进程共享）
+static long read_status_kb(const char* key)
+{
+    long value = -1;
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (!fp)
+    {
+        return value;
+    }
+    char line[256];
+    const size_t keylen = strlen(key);
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, key, keylen) == 0 && line[keylen] == ':')
+        {
+            value = atol(line + keylen + 1);
+            break;
+        }
+    }
+    fclose(fp);
+    return value;
+}
+
+// 统计read花费的时间，即从文件读出权重的部分；fp16转fp32、分配Mat等不在其中
+class TimedDataReader : public ncnn::DataReader
+{
+public:
+    explicit TimedDataReader(const ncnn::DataReader& dr) : dr_(dr)
+    {
+    }
+
+    size_t read(void* buf, size_t size) const override
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t n = dr_.read(buf, size);
+        read_ms_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return n;
+    }
+
+    double read_ms() const
+    {
+        return read_ms_;
+    }
+
+private:
+    const ncnn::DataReader& dr_;
+    mutable double read_ms_ = 0;
+};
+
+// 包装ncnn内置层，转发所有调用，单独累计create_pipeline（权重变换和重排）的耗时
+class PipelineTimedLayer : public ncnn::Layer
+{
+public:
+    struct Entry
+    {
+        std::string type;
+        double* pipeline_ms;
+    };
+
+    explicit PipelineTimedLayer(const Entry* entry) : layer_(ncnn::create_layer_cpu(entry->type.c_str())),
+        pipeline_ms_(entry->pipeline_ms)
+    {
+        sync_flags();
+    }
+
+    ~PipelineTimedLayer() override
+    {
+        delete layer_;
+    }
+
+    int load_param(const ncnn::ParamDict& pd) override
+    {
+        layer_->bottom_shapes = bottom_shapes;
+        layer_->top_shapes = top_shapes;
+        int ret = layer_->load_param(pd);
+        sync_flags();
+        return ret;
+    }
+
+    int load_model(const ncnn::ModelBin& mb) override
+    {
+        int ret = layer_->load_model(mb);
+        sync_flags();
+        return ret;
+    }
+
+    int create_pipeline(const ncnn::Option& opt) override
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int ret = layer_->create_pipeline(opt);
+        *pipeline_ms_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        sync_flags();
+        return ret;
+    }
+
+    int destroy_pipeline(const ncnn::Option& opt) override
+    {
+        return layer_->destroy_pipeline(opt);
+    }
+
+    using ncnn::Layer::forward;
+    using ncnn::Layer::forward_inplace;
+
+    int forward(const std::vector<ncnn::Mat>& bottom_blobs, std::vector<ncnn::Mat>& top_blobs,
+        const ncnn::Option& opt) const override
+    {
+        return layer_->forward(bottom_blobs, top_blobs, opt);
+    }
+
+    int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const override
+    {
+        return layer_->forward(bottom_blob, top_blob, opt);
+    }
+
+    int forward_inplace(std::vector<ncnn::Mat>& bottom_top_blobs, const ncnn::Option& opt) const override
+    {
+        return layer_->forward_inplace(bottom_top_blobs, opt);
+    }
+
+    int forward_inplace(ncnn::Mat& bottom_top_blob, const ncnn::Option& opt) const override
+    {
+        return layer_->forward_inplace(bottom_top_blob, opt);
+    }
+
+    static ncnn::Layer* creator(void* userdata)
+    {
+        return new PipelineTimedLayer((const Entry*)userdata);
+    }
+
+private:
+    // 内置层在构造、load_param和create_pipeline中都可能修改这些标志，Net读取的是包装层上的值
+    void sync_flags()
+    {
+        one_blob_only = layer_->one_blob_only;
+        support_inplace = layer_->support_inplace;
+        support_vulkan = false;
+        support_packing = layer_->support_packing;
+        support_bf16_storage = layer_->support_bf16_storage;
+        support_fp16_storage = layer_->support_fp16_storage;
+        support_int8_storage = layer_->support_int8_storage;
+        support_image_storage = layer_->support_image_storage;
+        support_tensor_storage = layer_->support_tensor_storage;
+        featmask = layer_->featmask;
+    }
+
+    ncnn::Layer* layer_;
+    double* pipeline_ms_;
+};
+
+// param中出现的层类型，第一行是magic，第二行是层数和blob数
+static std::vector<std::string> read_layer_types(const std::string& param_path)
+{
+    std::vector<std::string> types;
+    FILE* fp = fopen(param_path.c_str(), "r");
+    if (!fp)
+    {
+        return types;
+    }
+    char line[4096];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), fp))
+    {
+        char type[256];
+        if (lineno++ >= 2 && sscanf(line, "%255s", type) == 1
+            && std::find(types.begin(), types.end(), type) == types.end())
+        {
+            types.push_back(type);
+        }
+    }
+    fclose(fp);
+    return types;
+}
+
+// 不同Option下load_model的耗时拆分：read为读文件，create_pipeline为各层权重变换和重排（直接计时），
+// other为剩下的部分（fp16转fp32、分配Mat、各层load_model）
+static int run_repack(const std::string& param_path, const std::string& bin_path)
+{
+    struct Profile
+    {
+        const char* name;
+        void (*apply)(ncnn::Option& opt);
+    };
+    const Profile profiles[] = {
+        { "default", [](ncnn::Option&) {} },
+        { "no-winograd63", [](ncnn::Option& opt) { opt.use_winograd63_convolution = false; } },
+        { "no-winograd", [](ncnn::Option& opt) { opt.use_winograd_convolution = false; } },
+        { "no-sgemm", [](ncnn::Option& opt) { opt.use_sgemm_convolution = false; } },
+        { "no-packing", [](ncnn::Option& opt) { opt.use_packing_layout = false; } },
+    };
+    const std::vector<std::string> types = read_layer_types(param_path);
+    if (types.empty())
+    {
+        std::cerr << "load " << param_path << " failed" << std::endl;
+        return 1;
+    }
+    for (const Profile& profile : profiles)
+    {
+        double pipeline_ms = 0;
+        std::vector<PipelineTimedLayer::Entry> entries;
+        for (const std::string& type : types)
+        {
+            entries.push_back({ type, &pipeline_ms });
+        }
+
+        ncnn::Net net;
+        net.opt.num_threads = ncnn::get_big_cpu_count();
+        // lightmode决定create_pipeline后是否释放原始权重，各组固定为同一取值
+        net.opt.lightmode = true;
+        net.opt.use_vulkan_compute = false;
+        profile.apply(net.opt);
+        for (const PipelineTimedLayer::Entry& entry : entries)
+        {
+            net.register_custom_layer(entry.type.c_str(), PipelineTimedLayer::creator, 0, (void*)&entry);
+        }
+        if (net.load_param(param_path.c_str()) != 0)
+        {
+            std::cerr << "load " << param_path << " failed" << std::endl;
+            return 1;
+        }
+        FILE* fp = fopen(bin_path.c_str(), "rb");
+        if (!fp)
+        {
+            std::cerr << "open " << bin_path << " failed" << std::endl;
+            return 1;
+        }
+        ncnn::DataReaderFromStdio dr(fp);
+        TimedDataReader timed(dr);
+        auto start = std::chrono::high_resolution_clock::now();
+        int ret = net.load_model(timed);
+        double total = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        fclose(fp);
+        if (ret != 0)
+        {
+            std::cerr << "load " << bin_path << " failed" << std::endl;
+            return 1;
+        }
+        printf("%-14s load_model %8.2f ms   read %8.2f ms   create_pipeline %8.2f ms   other %8.2f ms\n",
+            profile.name, total, timed.read_ms(), pipeline_ms, total - timed.read_ms() - pipeline_ms);
+    }
+    return 0;
+}
+
+// 在当前进程中加载一次，输出耗时和加载前后的内存
+static int run_one(const std::string& param_path, const std::string& bin_path, bool use_mmap, bool cold)
+{
+    if (cold)
+    {
+        drop_page_cache(param_path);
+        drop_page_cache(bin_path);
+    }
+    const long rss0 = read_status_kb("VmRSS");
+    const long anon0 = read_status_kb("RssAnon");
+    const long file0 = read_status_kb("RssFile");
+
+    Yolov11 model;
+    auto start = std::chrono::high_resolution_clock::now();
+    bool ok = model.load_model(param_path.c_str(), bin_path.c_str(), 640, false, 0, 0, use_mmap);
+    auto end = std::chrono::high_resolution_clock::now();
+    if (!ok)
+    {
+        std::cerr << "load " << bin_path << " failed" << std::endl;
+        return 1;
+    }
+
+    printf("%-6s %-4s load %8.2f ms   rss +%6ld KB   private +%6ld KB   file-backed +%6ld KB\n",
+        use_mmap ? "mmap" : "stream", cold ? "cold" : "warm",
+        std::chrono::duration<double, std::milli>(end - start).count(),
+        read_status_kb("VmRSS") - rss0, read_status_kb("RssAnon") - anon0, read_status_kb("RssFile") - file0);
+    return 0;
+}
+
+// 模型加载的冷/热启动耗时和每个进程的内存，每种方式在独立的子进程中运行
+// 用法: bench_model_load [param] [bin]，或 bench_model_load param bin stream|mmap cold|warm 只运行一种，
+// bench_model_load param bin repack 输出load_model中读取、create_pipeline和其余部分的耗时
+int main(int argc, char** argv)
+{
+    const std::string param_path = argc > 1 ? argv[1] : "../assets/yolo11n_ncnn_model/model.ncnn.param";
+    const std::string bin_path = argc > 2 ? argv[2] : "../assets/yolo11n_ncnn_model/model.ncnn.bin";
+
+    if (argc == 4 && strcmp(argv[3], "repack") == 0)
+    {
+        return run_repack(param_path, bin_path);
+    }
+
+    if (argc > 4)
+    {
+        return run_one(param_path, bin_path, strcmp(argv[3], "mmap") == 0, strcmp(argv[4], "cold") == 0);
+    }
+
+    const char* modes[] = { "stream", "mmap" };
+    const char* starts[] = { "cold", "warm" };
+    int failures = 0;
+    for (const char* mode : modes)
+    {
+        for (const char* start : starts)
+        {
+            std::string cmd = std::string("\"") + argv[0] + "\" \"" + param_path + "\" \"" + bin_path + "\" " + mode
+                + " " + start;
+            fflush(stdout);
+            failures += system(cmd.c_str()) != 0;
+        }
+    }
+    return failures != 0;
+}
@@ -0,0 +1,274 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <ncnn/net.h>
+#include "common.h"
+
+// 统计全局operator new的调用次数
+static std::atomic<long long> g_alloc_count(0);
+static std::atomic<bool> g_counting(false);
+
+void* operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// 原来的scan：每次分配格式字符串，拼接%n后调用sscanf
+class LegacyScanReader : public ncnn::DataReader
+{
+public:
+    explicit LegacyScanReader(const std::string& text) : text_(text)
+    {
+    }
+
+    int scan(const char* format, void* p) const override
+    {
+        size_t fmtlen = strlen(format);
+
+        char* format_with_n = new char[fmtlen + 4];
+        sprintf(format_with_n, "%s%%n", format);
+
+        int nconsumed = 0;
+        int nscan = sscanf(text_.c_str() + offset_, format_with_n, p, &nconsumed);
+        offset_ += nconsumed;
+
+        delete[] format_with_n;
+
+        return nconsumed > 0 ? nscan : 0;
+    }
+
+    size_t read(void*, size_t) const override
+    {
+        return 0;
+    }
+
+private:
+    std::string text_;
+    mutable size_t offset_ = 0;
+};
+
+static void hash_bytes(unsigned long long& h, const void* data, size_t n)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; i++)
+    {
+        h = (h ^ p[i]) * 1099511628211ull;
+    }
+}
+
+// 按ncnn解析param时的scan调用顺序走一遍，返回所有读出的值的哈希，scans为scan的调用次数
+static bool replay_param(const ncnn::DataReader& dr, unsigned long long& hash, long long& scans)
+{
+    hash = 14695981039346656037ull;
+    scans = 0;
+    int magic = 0, layer_count = 0, blob_count = 0;
+    scans += 3;
+    if (dr.scan("%d", &magic) != 1 || dr.scan("%d", &layer_count) != 1 || dr.scan("%d", &blob_count) != 1)
+    {
+        return false;
+    }
+    hash_bytes(hash, &magic, sizeof(magic));
+    for (int i = 0; i < layer_count; i++)
+    {
+        char layer_type[256];
+        char layer_name[256];
+        int bottom_count = 0, top_count = 0;
+        scans += 4;
+        if (dr.scan("%255s", layer_type) != 1 || dr.scan("%255s", layer_name) != 1
+            || dr.scan("%d", &bottom_count) != 1 || dr.scan("%d", &top_count) != 1)
+        {
+            return false;
+        }
+        hash_bytes(hash, layer_type, strlen(layer_type));
+        hash_bytes(hash, layer_name, strlen(layer_name));
+        for (int j = 0; j < bottom_count + top_count; j++)
+        {
+            char blob_name[256];
+            scans++;
+            if (dr.scan("%255s", blob_name) != 1)
+            {
+                return false;
+            }
+            hash_bytes(hash, blob_name, strlen(blob_name));
+        }
+        // ParamDict::load_param
+        int id = 0;
+        while (scans++, dr.scan("%d=", &id) == 1)
+        {
+            hash_bytes(hash, &id, sizeof(id));
+            if (id <= -23300)
+            {
+                int len = 0;
+                scans++;
+                if (dr.scan("%d", &len) != 1)
+                {
+                    return false;
+                }
+                for (int k = 0; k < len; k++)
+                {
+                    char vstr[16];
+                    scans++;
+                    if (dr.scan(",%15[^,\n ]", vstr) != 1)
+                    {
+                        return false;
+                    }
+                    hash_bytes(hash, vstr, strlen(vstr));
+                }
+            }
+            else
+            {
+                char vstr[16];
+                scans++;
+                if (dr.scan("%15s", vstr) != 1)
+                {
+                    return false;
+                }
+                hash_bytes(hash, vstr, strlen(vstr));
+            }
+        }
+    }
+    return true;
+}
+
+static double ms_since(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// 明文和加密param的加载耗时
+// 用法: bench_param_load [param] [重复次数]
+int main(int argc, char** argv)
+{
+    const std::string param_path = argc > 1 ? argv[1] : "../assets/yolo11n_ncnn_model/model.ncnn.param";
+    const int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    const std::string encrypted_path = "bench_param_load.param";
+    const unsigned char key = 0x5a;
+
+    std::string text;
+    {
+        FILE* fp = fopen(param_path.c_str(), "rb");
+        if (!fp)
+        {
+            std::cerr << "open " << param_path << " failed" << std::endl;
+            return 1;
+        }
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        {
+            text.append(buf, n);
+        }
+        fclose(fp);
+    }
+    {
+        std::string encrypted = text;
+        for (char& c : encrypted)
+        {
+            c ^= key;
+        }
+        FILE* fp = fopen(encrypted_path.c_str(), "wb");
+        if (!fp || fwrite(encrypted.data(), 1, encrypted.size(), fp) != encrypted.size())
+        {
+            std::cerr << "write " << encrypted_path << " failed" << std::endl;
+            return 1;
+        }
+        fclose(fp);
+    }
+
+    int failures = 0;
+
+    // 只看scan：原来的sscanf实现和新的分词实现走同样的调用序列
+    {
+        unsigned long long legacy_hash = 0, new_hash = 0;
+        long long scans = 0, legacy_allocs = 0, new_allocs = 0;
+        double legacy_ms = 0, new_ms = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            LegacyScanReader legacy(text);
+            g_alloc_count.store(0);
+            g_counting.store(true);
+            auto start = std::chrono::high_resolution_clock::now();
+            failures += !replay_param(legacy, legacy_hash, scans);
+            legacy_ms += ms_since(start);
+            g_counting.store(false);
+            legacy_allocs += g_alloc_count.load();
+
+            MyEncryptedDataReader reader(encrypted_path.c_str(), key, true);
+            g_alloc_count.store(0);
+            g_counting.store(true);
+            start = std::chrono::high_resolution_clock::now();
+            failures += !replay_param(reader, new_hash, scans);
+            new_ms += ms_since(start);
+            g_counting.store(false);
+            new_allocs += g_alloc_count.load();
+        }
+        failures += legacy_hash != new_hash;
+        printf("scan replay (%lld scans)  sscanf %7.3f ms  %6lld allocs   tokenizer %7.3f ms  %6lld allocs   %s\n",
+            scans, legacy_ms / iterations, legacy_allocs / iterations, new_ms / iterations, new_allocs / iterations,
+            legacy_hash == new_hash ? "match" : "MISMATCH");
+    }
+
+    // 完整的ncnn::Net::load_param
+    {
+        double plain_ms = 0, encrypted_ms = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            ncnn::Net plain;
+            auto start = std::chrono::high_resolution_clock::now();
+            failures += plain.load_param(param_path.c_str()) != 0;
+            plain_ms += ms_since(start);
+
+            ncnn::Net encrypted;
+            start = std::chrono::high_resolution_clock::now();
+            MyEncryptedDataReader reader(encrypted_path.c_str(), key, true);
+            failures += encrypted.load_param(reader) != 0;
+            encrypted_ms += ms_since(start);
+        }
+        printf("load_param                plain  %7.3f ms                 encrypted %7.3f ms\n", plain_ms / iterations,
+            encrypted_ms / iterations);
+    }
+    remove(encrypted_path.c_str());
+
+    std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+    return failures != 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "preprocess.h"
+
+// 对比原来的 from_pixels_resize + copy_make_border + substract_mean_normalize 和融合的预处理
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? atoi(argv[1]) : 50;
+    const int input_size = 640;
+    const int sizes[3][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+
+    std::mt19937 rng(0);
+    for (auto size : sizes)
+    {
+        const int img_w = size[0];
+        const int img_h = size[1];
+        std::vector<unsigned char> bgr((size_t)img_w * img_h * 3);
+        for (auto& v : bgr)
+        {
+            v = (unsigned char)(rng() & 0xff);
+        }
+
+        float scale = (float)input_size / img_w;
+        int w = input_size;
+        int h = img_h * scale;
+        int wpad = input_size - w;
+        int hpad = input_size - h;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < iterations; it++)
+        {
+            ncnn::Mat in = ncnn::Mat::from_pixels_resize(bgr.data(), ncnn::Mat::PIXEL_BGR2RGB, img_w, img_h, w, h);
+            ncnn::Mat in_pad;
+            ncnn::copy_make_border(in, in_pad, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2,
+                ncnn::BORDER_CONSTANT, 114.f);
+            const float norm_vals[3] = { 1 / 255.f, 1 / 255.f, 1 / 255.f };
+            in_pad.substract_mean_normalize(0, norm_vals);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        LetterboxInfo info;
+        info.dst_w = input_size;
+        info.dst_h = input_size;
+        info.resized_w = w;
+        info.resized_h = h;
+        info.left = wpad / 2;
+        info.top = hpad / 2;
+        info.scale = scale;
+        LetterboxPreprocessor preprocessor;
+        ncnn::Mat in;
+        for (int it = 0; it < iterations; it++)
+        {
+            preprocessor.run(bgr.data(), img_w, img_h, img_w * 3, info, in);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        double ms_before = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1000.0 / iterations;
+        double ms_after = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / 1000.0 / iterations;
+        std::cout << img_w << "x" << img_h << ": before " << ms_before << " ms, after " << ms_after
+            << " ms, speedup " << ms_before / ms_after << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "byte_track/BYTETracker.h"
+
+// 网格排列的目标缓慢移动，每帧都被检测到，跟踪器中的轨迹数约等于目标数
+static void make_frame(int frame, int num_objects, std::vector<Object>& objects)
+{
+    const int cols = (int)std::ceil(std::sqrt((float)num_objects));
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        Object obj;
+        obj.rect.x = (i % cols) * 60.f + 5.f * std::sin(0.05f * frame + i);
+        obj.rect.y = (i / cols) * 80.f + 5.f * std::cos(0.05f * frame + i);
+        obj.rect.width = 40.f;
+        obj.rect.height = 60.f;
+        obj.prob = (frame + i) % 11 == 0 ? 0.3f : 0.8f;
+        obj.label = 0;
+        objects.push_back(obj);
+    }
+}
+
+// 每条轨迹占用的字节数和不同轨迹数下update的耗时
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        sizes.push_back(atoi(argv[i]));
+    }
+    if (sizes.empty())
+    {
+        sizes = { 100, 1000, 5000 };
+    }
+
+    std::cout << "sizeof(STrack): " << sizeof(STrack) << " bytes" << std::endl;
+
+    for (int num_objects : sizes)
+    {
+        BYTETracker tracker(30, 30);
+        std::vector<Object> objects;
+        std::vector<const STrack*> output;
+
+        const int warmup = 5;
+        const int frames = num_objects >= 5000 ? 5 : 20;
+        for (int f = 0; f < warmup; f++)
+        {
+            make_frame(f, num_objects, objects);
+            tracker.update(objects, output);
+        }
+
+        double total_ms = 0;
+        for (int f = warmup; f < warmup + frames; f++)
+        {
+            make_frame(f, num_objects, objects);
+            auto start = std::chrono::high_resolution_clock::now();
+            tracker.update(objects, output);
+            auto end = std::chrono::high_resolution_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        std::cout << num_objects << " tracks: " << total_ms / frames << " ms per update, " << output.size()
+            << " active" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "byte_track/BYTETracker.h"
+
+// 网格排列的目标缓慢移动；每个目标周期性地消失一段时间，跟踪器中始终有大量lost轨迹，
+// joint/sub/remove_duplicate处理的列表长度都与目标数成正比
+static void make_frame(int frame, int num_objects, std::vector<Object>& objects)
+{
+    const int cols = (int)std::ceil(std::sqrt((float)num_objects));
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        if ((frame + i * 3) % 40 < 8)
+        {
+            continue;
+        }
+        Object obj;
+        obj.rect.x = (i % cols) * 60.f + 5.f * std::sin(0.05f * frame + i);
+        obj.rect.y = (i / cols) * 80.f + 5.f * std::cos(0.05f * frame + i);
+        obj.rect.width = 40.f;
+        obj.rect.height = 60.f;
+        obj.prob = (frame + i) % 11 == 0 ? 0.3f : 0.8f;
+        obj.label = 0;
+        objects.push_back(obj);
+    }
+}
+
+// 目标数每次翻倍，update的耗时也应该大致翻倍，每条轨迹的耗时基本不变
+int main(int argc, char** argv)
+{
+    const int max_objects = argc > 1 ? atoi(argv[1]) : 16000;
+
+    double last_ms = 0;
+    for (int num_objects = 250; num_objects <= max_objects; num_objects *= 2)
+    {
+        BYTETracker tracker(30, 30);
+        std::vector<Object> objects;
+        std::vector<const STrack*> output;
+
+        const int warmup = 45;
+        const int frames = 40;
+        for (int f = 0; f < warmup; f++)
+        {
+            make_frame(f, num_objects, objects);
+            tracker.update(objects, output);
+        }
+
+        double total_ms = 0;
+        for (int f = warmup; f < warmup + frames; f++)
+        {
+            make_frame(f, num_objects, objects);
+            auto start = std::chrono::high_resolution_clock::now();
+            tracker.update(objects, output);
+            auto end = std::chrono::high_resolution_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        const double ms = total_ms / frames;
+        std::cout << num_objects << " objects: " << ms << " ms per update, " << ms * 1000 / num_objects
+            << " us per object";
+        if (last_ms > 0)
+        {
+            std::cout << ", x" << ms / last_ms << " vs half size";
+        }
+        std::cout << std::endl;
+        last_ms = ms;
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include "decoder.h"
+
+// 原来的逐类sigmoid解码：NaN的比较为false，不会被选为最大类别
+static inline float sigmoid(float x)
+{
+    return 1.0f / (1.0f + expf(-x));
+}
+
+static void reference_proposals(int stride, const ncnn::Mat& feat_blob, float prob_threshold, int reg_max,
+    std::vector<Object>& objects)
+{
+    const int num_class = feat_blob.w - 4 * reg_max;
+    for (int i = 0; i < feat_blob.c; i++)
+    {
+        for (int j = 0; j < feat_blob.h; j++)
+        {
+            const float* scores = (const float*)feat_blob.channel(i).row(j) + 4 * reg_max;
+            int class_index = 0;
+            float class_score = -FLT_MAX;
+            for (int c = 0; c < num_class; c++)
+            {
+                if (sigmoid(scores[c]) > class_score)
+                {
+                    class_index = c;
+                    class_score = sigmoid(scores[c]);
+                }
+            }
+            if (class_score >= prob_threshold)
+            {
+                // DFL全为0时分布均匀，每条边的期望都是(reg_max - 1) / 2
+                const float d = (reg_max - 1) * 0.5f;
+                Object obj;
+                obj.rect.x = (j + 0.5f - d) * stride;
+                obj.rect.y = (i + 0.5f - d) * stride;
+                obj.label = class_index;
+                obj.prob = class_score;
+                objects.push_back(obj);
+            }
+        }
+    }
+}
+
+// 随机格子里放入NaN：整行NaN、最后一个类别NaN、NaN夹在最大值前后，类别数覆盖SIMD的尾部
+static ncnn::Mat make_feat(std::mt19937& rng, int grid, int reg_max, int num_class)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    ncnn::Mat feat(4 * reg_max + num_class, grid, grid);
+    std::normal_distribution<float> logit(-3.f, 3.f);
+    std::uniform_int_distribution<int> kind(0, 5);
+    std::uniform_int_distribution<int> pick(0, num_class - 1);
+    for (int i = 0; i < grid; i++)
+    {
+        for (int j = 0; j < grid; j++)
+        {
+            float* p = feat.channel(i).row(j);
+            for (int k = 0; k < 4 * reg_max; k++)
+            {
+                p[k] = 0.f;
+            }
+            float* scores = p + 4 * reg_max;
+            for (int c = 0; c < num_class; c++)
+            {
+                scores[c] = logit(rng);
+            }
+            switch (kind(rng))
+            {
+            case 0:
+                for (int c = 0; c < num_class; c++)
+                {
+                    scores[c] = nan;
+                }
+                break;
+            case 1:
+                scores[num_class - 1] = nan;
+                break;
+            case 2:
+                scores[pick(rng)] = nan;
+                scores[pick(rng)] = nan;
+                break;
+            case 3:
+                scores[0] = nan;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return feat;
+}
+
+static int compare(int reg_max, int num_class, float prob_threshold)
+{
+    std::mt19937 rng(num_class * 131 + reg_max);
+    ncnn::Mat feat = make_feat(rng, 20, reg_max, num_class);
+    std::vector<Object> expected, actual;
+    reference_proposals(8, feat, prob_threshold, reg_max, expected);
+    decode_proposals(8, feat, inverse_sigmoid(prob_threshold), actual, reg_max);
+
+    int failures = expected.size() == actual.size() ? 0 : 1;
+    for (size_t k = 0; k < expected.size() && k < actual.size(); k++)
+    {
+        if (expected[k].label != actual[k].label || std::fabs(expected[k].rect.x - actual[k].rect.x) > 1e-3f
+            || std::fabs(expected[k].rect.y - actual[k].rect.y) > 1e-3f || std::fabs(expected[k].prob - actual[k].prob) > 1e-6f)
+        {
+            failures++;
+        }
+    }
+    if (failures != 0)
+    {
+        std::cerr << "reg_max " << reg_max << " num_class " << num_class << " thresh " << prob_threshold
+            << ": expected " << expected.size() << " proposals, got " << actual.size() << std::endl;
+    }
+    return failures;
+}
+
+// 含NaN的类别logit：解码不越界，结果与逐类比较一致
+int main()
+{
+    int failures = 0;
+    const int num_classes[] = { 1, 3, 7, 8, 13, 80 };
+    for (int num_class : num_classes)
+    {
+        failures += compare(16, num_class, 0.25f);
+        failures += compare(16, num_class, 0.9f);
+        failures += compare(1, num_class, 0.5f);
+    }
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
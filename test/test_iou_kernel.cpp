@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "byte_track/iouKernel.h"
+#include "byte_track/sparseAssociation.h"
+
+// 随机框，包含不相交、边界相接、完全重合和退化的框
+static void random_boxes(std::mt19937& rng, int n, TlbrBoxes& boxes, std::vector<float>& tlbrs)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    boxes.resize(n);
+    tlbrs.resize(n * 4);
+    for (int i = 0; i < n; i++)
+    {
+        float* t = &tlbrs[i * 4];
+        const int kind = (int)(uniform(rng) * 10);
+        if (kind == 0 && i > 0)
+        {
+            memcpy(t, &tlbrs[(i - 1) * 4], 4 * sizeof(float)); // 与上一个框重合
+        }
+        else if (kind == 1 && i > 0)
+        {
+            t[0] = tlbrs[(i - 1) * 4 + 2] + 1; // 与上一个框在+1像素的边界上相接
+            t[1] = tlbrs[(i - 1) * 4 + 1];
+            t[2] = t[0] + 20;
+            t[3] = t[1] + 20;
+        }
+        else if (kind == 2)
+        {
+            t[0] = t[2] = uniform(rng) * 200; // 宽度为0
+            t[1] = uniform(rng) * 200;
+            t[3] = t[1] + uniform(rng) * 50;
+        }
+        else
+        {
+            t[0] = uniform(rng) * 200;
+            t[1] = uniform(rng) * 200;
+            t[2] = t[0] + uniform(rng) * 80;
+            t[3] = t[1] + uniform(rng) * 80;
+        }
+        boxes.set(i, t);
+    }
+}
+
+// SIMD核与标量实现、tlbr_iou_distance逐位比较，覆盖各种尾部长度
+int main()
+{
+    std::cout << "iou kernel: " << iou_kernel_name() << std::endl;
+
+    std::mt19937 rng(7);
+    TlbrBoxes a, b;
+    std::vector<float> atlbrs, btlbrs, cost, ref;
+    int failures = 0;
+
+    for (int rows = 0; rows <= 9; rows += 3)
+    {
+        for (int cols = 0; cols <= 70; cols++)
+        {
+            random_boxes(rng, rows, a, atlbrs);
+            random_boxes(rng, cols, b, btlbrs);
+            cost.assign((size_t)rows * cols, -1.f);
+            ref.assign((size_t)rows * cols, -2.f);
+            iou_distance_matrix(a, b, cost.data());
+            iou_distance_matrix_scalar(a, b, ref.data());
+
+            for (int n = 0; n < rows; n++)
+            {
+                for (int k = 0; k < cols; k++)
+                {
+                    const float c = cost[n * cols + k];
+                    const float r = ref[n * cols + k];
+                    const float t = tlbr_iou_distance(&atlbrs[n * 4], &btlbrs[k * 4]);
+                    if (memcmp(&c, &r, sizeof(float)) != 0 || memcmp(&c, &t, sizeof(float)) != 0)
+                    {
+                        if (failures < 10)
+                        {
+                            std::cerr << "mismatch at " << rows << "x" << cols << " (" << n << ", " << k << "): "
+                                << c << " vs " << r << " / " << t << std::endl;
+                        }
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+
+    // 500 x 500的耗时
+    random_boxes(rng, 500, a, atlbrs);
+    random_boxes(rng, 500, b, btlbrs);
+    cost.resize(500 * 500);
+    const int rounds = 50;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        iou_distance_matrix_scalar(a, b, cost.data());
+    }
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        iou_distance_matrix(a, b, cost.data());
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "500x500 scalar: " << std::chrono::duration<double, std::milli>(mid - start).count() / rounds
+        << " ms, " << iou_kernel_name() << ": " << std::chrono::duration<double, std::milli>(end - mid).count() / rounds
+        << " ms" << std::endl;
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
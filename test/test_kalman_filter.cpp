@@ -0,0 +1,337 @@
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "byte_track/kalmanFilter.h"
+#include "byte_track/batchKalmanFilter.h"
+
+// 原来的通用实现：8x8稠密乘法和LLT分解。T为float时就是原来的滤波器，T为double时作为精度的基准
+template<typename T>
+class ReferenceKalmanFilter
+{
+public:
+    typedef Eigen::Matrix<T, 1, 8, Eigen::RowMajor> Mean;
+    typedef Eigen::Matrix<T, 8, 8, Eigen::RowMajor> Cova;
+    typedef Eigen::Matrix<T, 1, 4, Eigen::RowMajor> Box;
+    typedef Eigen::Matrix<T, 4, 4, Eigen::RowMajor> HCova;
+
+    ReferenceKalmanFilter()
+    {
+        _motion_mat = Cova::Identity();
+        for (int i = 0; i < 4; i++)
+        {
+            _motion_mat(i, 4 + i) = 1.;
+        }
+        _update_mat = Eigen::Matrix<T, 4, 8, Eigen::RowMajor>::Identity();
+        _std_weight_position = (float)(1. / 20);
+        _std_weight_velocity = (float)(1. / 160);
+    }
+
+    void predict(Mean& mean, Cova& covariance)
+    {
+        Mean std;
+        std << _std_weight_position * mean(3), _std_weight_position * mean(3), (T)1e-2f,
+            _std_weight_position * mean(3), _std_weight_velocity * mean(3), _std_weight_velocity * mean(3),
+            (T)1e-5f, _std_weight_velocity * mean(3);
+        Mean tmp = std.array().square();
+        Cova motion_cov = tmp.asDiagonal();
+        Mean mean1 = _motion_mat * mean.transpose();
+        Cova covariance1 = _motion_mat * covariance * (_motion_mat.transpose());
+        covariance1 += motion_cov;
+        mean = mean1;
+        covariance = covariance1;
+    }
+
+    void project(const Mean& mean, const Cova& covariance, Box& mean1, HCova& covariance1)
+    {
+        Box std;
+        std << _std_weight_position * mean(3), _std_weight_position * mean(3), (T)1e-1f, _std_weight_position * mean(3);
+        mean1 = _update_mat * mean.transpose();
+        covariance1 = _update_mat * covariance * (_update_mat.transpose());
+        HCova diag = std.asDiagonal();
+        diag = diag.array().square().matrix();
+        covariance1 += diag;
+    }
+
+    void update(Mean& mean, Cova& covariance, const Box& measurement)
+    {
+        Box projected_mean;
+        HCova projected_cov;
+        project(mean, covariance, projected_mean, projected_cov);
+        Eigen::Matrix<T, 4, 8> B = (covariance * (_update_mat.transpose())).transpose();
+        Eigen::Matrix<T, 8, 4> kalman_gain = (projected_cov.llt().solve(B)).transpose();
+        Box innovation = measurement - projected_mean;
+        Mean tmp = innovation * (kalman_gain.transpose());
+        Cova new_covariance = covariance - kalman_gain * projected_cov * (kalman_gain.transpose());
+        mean = mean + tmp;
+        covariance = new_covariance;
+    }
+
+    T gating_distance(const Mean& mean, const Cova& covariance, const Box& measurement)
+    {
+        Box mean1;
+        HCova covariance1;
+        project(mean, covariance, mean1, covariance1);
+        Eigen::Matrix<T, 4, 1> d = (measurement - mean1).transpose();
+        Eigen::Matrix<T, 4, 1> z = covariance1.llt().matrixL().solve(d);
+        return z.squaredNorm();
+    }
+
+private:
+    Cova _motion_mat;
+    Eigen::Matrix<T, 4, 8, Eigen::RowMajor> _update_mat;
+    T _std_weight_position;
+    T _std_weight_velocity;
+};
+
+// 与double基准的最大相对误差。均值中宽高比及其速度以0.001为尺度，其余以1像素为尺度；协方差以 sqrt(P_rr * P_cc) 为尺度
+struct FilterError
+{
+    double mean = 0;
+    double cova = 0;
+    double gating = 0;
+};
+
+static double relative_error(double value, double reference, double scale)
+{
+    return std::fabs(value - reference) / std::max(std::fabs(reference), scale);
+}
+
+template<typename M, typename C>
+static void accumulate_error(const M& mean, const C& cova, const ReferenceKalmanFilter<double>::Mean& ref_mean,
+    const ReferenceKalmanFilter<double>::Cova& ref_cova, FilterError& error)
+{
+    for (int r = 0; r < 8; r++)
+    {
+        error.mean = std::max(error.mean, relative_error(mean(r), ref_mean(r), r % 4 == 2 ? 1e-3 : 1.0));
+        for (int c = 0; c < 8; c++)
+        {
+            const double scale = std::sqrt(ref_cova(r, r) * ref_cova(c, c));
+            error.cova = std::max(error.cova, relative_error(cova(r, c), ref_cova(r, c), scale));
+        }
+    }
+}
+
+// 模拟目标：匀速运动，速度随机扰动，观测带噪声，随机漏检，偶尔长时间丢失
+struct Target
+{
+    float x, y, a, h;
+    float vx, vy, vh;
+    int lost;
+};
+
+static double elapsed_ns(std::chrono::high_resolution_clock::time_point start,
+    std::chrono::high_resolution_clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// 在长时间的随机轨迹上，新实现、原来的float实现都与double基准逐帧比较；批量接口与单条轨迹接口比较
+int main()
+{
+    const int num_tracks = 256;
+    const int num_frames = 2000;
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::normal_distribution<float> normal(0.f, 1.f);
+
+    byte_kalman::KalmanFilter kalman;
+    byte_kalman::BatchKalmanFilter batch;
+    ReferenceKalmanFilter<float> reference;
+    ReferenceKalmanFilter<double> truth;
+
+    std::vector<Target> targets(num_tracks);
+    std::vector<KAL_MEAN> ref_mean(num_tracks), new_mean(num_tracks), batch_mean(num_tracks);
+    std::vector<KAL_COVA> ref_cova(num_tracks), new_cova(num_tracks), batch_cova(num_tracks);
+    std::vector<ReferenceKalmanFilter<double>::Mean> truth_mean(num_tracks);
+    std::vector<ReferenceKalmanFilter<double>::Cova> truth_cova(num_tracks);
+    std::vector<char> missed(num_tracks, 0);
+    for (int i = 0; i < num_tracks; i++)
+    {
+        Target& t = targets[i];
+        t.x = uniform(rng) * 1920;
+        t.y = uniform(rng) * 1080;
+        t.h = 30 + uniform(rng) * 200;
+        t.a = 0.3f + uniform(rng) * 0.7f;
+        t.vx = normal(rng) * 3;
+        t.vy = normal(rng) * 2;
+        t.vh = normal(rng) * 0.2f;
+        t.lost = 0;
+
+        DETECTBOX box;
+        box << t.x, t.y, t.a, t.h;
+        KAL_DATA init = kalman.initiate(box);
+        ref_mean[i] = new_mean[i] = batch_mean[i] = init.first;
+        ref_cova[i] = new_cova[i] = batch_cova[i] = init.second;
+        truth_mean[i] = init.first.cast<double>();
+        truth_cova[i] = init.second.cast<double>();
+    }
+
+    FilterError new_error, ref_error, batch_error;
+    long long updates = 0;
+    std::vector<int> update_index;
+    std::vector<DETECTBOX> measurements(num_tracks);
+
+    for (int frame = 0; frame < num_frames; frame++)
+    {
+        // 与跟踪器一样，丢失的轨迹预测前把高度的速度置0
+        for (int i = 0; i < num_tracks; i++)
+        {
+            if (missed[i])
+            {
+                ref_mean[i](7) = new_mean[i](7) = batch_mean[i](7) = 0;
+                truth_mean[i](7) = 0;
+            }
+            reference.predict(ref_mean[i], ref_cova[i]);
+            truth.predict(truth_mean[i], truth_cova[i]);
+            kalman.predict(new_mean[i], new_cova[i]);
+        }
+        batch.resize(num_tracks);
+        for (int i = 0; i < num_tracks; i++)
+        {
+            batch.set(i, batch_mean[i], batch_cova[i]);
+        }
+        batch.predict();
+        for (int i = 0; i < num_tracks; i++)
+        {
+            batch.get(i, batch_mean[i], batch_cova[i]);
+        }
+
+        // 目标运动并生成观测
+        update_index.clear();
+        for (int i = 0; i < num_tracks; i++)
+        {
+            Target& t = targets[i];
+            t.vx += normal(rng) * 0.2f;
+            t.vy += normal(rng) * 0.2f;
+            t.x += t.vx;
+            t.y += t.vy;
+            t.h = std::max(10.f, t.h + t.vh);
+            t.a = std::min(2.f, std::max(0.2f, t.a + normal(rng) * 0.005f));
+            missed[i] = 1;
+            if (t.lost > 0)
+            {
+                t.lost--;
+                continue;
+            }
+            if (uniform(rng) < 0.002f)
+            {
+                t.lost = 10 + (int)(uniform(rng) * 50);
+                continue;
+            }
+            if (uniform(rng) < 0.1f)
+            {
+                continue;
+            }
+            measurements[i] << t.x + normal(rng) * 2, t.y + normal(rng) * 2, t.a + normal(rng) * 0.01f,
+                t.h + normal(rng) * 2;
+            missed[i] = 0;
+            update_index.push_back(i);
+        }
+
+        // 门限距离在更新之前比较
+        for (int k = 0; k < update_index.size(); k++)
+        {
+            const int i = update_index[k];
+            std::vector<DETECTBOX> one(1, measurements[i]);
+            const double d = truth.gating_distance(truth_mean[i], truth_cova[i], measurements[i].cast<double>());
+            new_error.gating = std::max(new_error.gating,
+                relative_error(kalman.gating_distance(new_mean[i], new_cova[i], one)(0), d, 1.0));
+            ref_error.gating = std::max(ref_error.gating,
+                relative_error(reference.gating_distance(ref_mean[i], ref_cova[i], measurements[i]), d, 1.0));
+        }
+
+        // 更新：批量接口只更新有观测的轨迹
+        batch.resize(update_index.size());
+        for (int k = 0; k < update_index.size(); k++)
+        {
+            const int i = update_index[k];
+            reference.update(ref_mean[i], ref_cova[i], measurements[i]);
+            truth.update(truth_mean[i], truth_cova[i], measurements[i].cast<double>());
+            KAL_DATA mc = kalman.update(new_mean[i], new_cova[i], measurements[i]);
+            new_mean[i] = mc.first;
+            new_cova[i] = mc.second;
+
+            batch.set(k, batch_mean[i], batch_cova[i]);
+            batch.set_measurement(k, measurements[i].data());
+        }
+        batch.update();
+        for (int k = 0; k < update_index.size(); k++)
+        {
+            batch.get(k, batch_mean[update_index[k]], batch_cova[update_index[k]]);
+        }
+        updates += update_index.size();
+
+        for (int i = 0; i < num_tracks; i++)
+        {
+            accumulate_error(new_mean[i], new_cova[i], truth_mean[i], truth_cova[i], new_error);
+            accumulate_error(ref_mean[i], ref_cova[i], truth_mean[i], truth_cova[i], ref_error);
+            accumulate_error(batch_mean[i], batch_cova[i], new_mean[i].cast<double>(), new_cova[i].cast<double>(),
+                batch_error);
+        }
+    }
+
+    std::cout << "tracks: " << num_tracks << ", frames: " << num_frames << ", updates: " << updates << std::endl;
+    std::cout << "max relative error vs double  specialized: mean " << new_error.mean << ", covariance "
+        << new_error.cova << ", gating " << new_error.gating << std::endl;
+    std::cout << "max relative error vs double  original:    mean " << ref_error.mean << ", covariance "
+        << ref_error.cova << ", gating " << ref_error.gating << std::endl;
+    std::cout << "batch vs single-track: mean " << batch_error.mean << ", covariance " << batch_error.cova
+        << std::endl;
+
+    // 一次预测加一次更新的耗时
+    const int rounds = 100000;
+    DETECTBOX measurement;
+    measurement << 500, 300, 0.5f, 120;
+    KAL_DATA init = kalman.initiate(measurement);
+    KAL_MEAN m = init.first;
+    KAL_COVA p = init.second;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        reference.predict(m, p);
+        reference.update(m, p, measurement);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    m = init.first;
+    p = init.second;
+    for (int r = 0; r < rounds; r++)
+    {
+        kalman.predict(m, p);
+        KAL_DATA mc = kalman.update(m, p, measurement);
+        m = mc.first;
+        p = mc.second;
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+    batch.resize(num_tracks);
+    for (int i = 0; i < num_tracks; i++)
+    {
+        batch.set(i, init.first, init.second);
+        batch.set_measurement(i, measurement.data());
+    }
+    for (int r = 0; r < rounds / num_tracks; r++)
+    {
+        batch.predict();
+        batch.update();
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    const int batch_rounds = rounds / num_tracks * num_tracks;
+    std::cout << "predict + update per track  original: " << elapsed_ns(t0, t1) / rounds << " ns, specialized: "
+        << elapsed_ns(t1, t2) / rounds << " ns, batch: " << elapsed_ns(t2, t3) / batch_rounds << " ns" << std::endl;
+
+    // float的舍入误差会在长轨迹上累积，新实现的误差与原来的float实现在同一量级即可
+    const bool ok = new_error.mean <= std::max(2 * ref_error.mean, 1e-4) &&
+        new_error.cova <= std::max(2 * ref_error.cova, 1e-4) &&
+        new_error.gating <= std::max(2 * ref_error.gating, 1e-4) &&
+        batch_error.mean < 1e-5 && batch_error.cova < 1e-5;
+    if (!ok)
+    {
+        std::cerr << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "lockfree_queue.h"
+
+// 多生产者多消费者：每个值恰好出队一次，同一个生产者的值在每个消费者看来保持入队顺序
+static int stress_queue(int num_producers, int num_consumers, int per_producer, size_t capacity)
+{
+    LockFreeQueue<uint64_t> queue(capacity);
+    std::vector<std::atomic<int>> seen((size_t)num_producers * per_producer);
+    for (auto& s : seen)
+    {
+        s.store(0);
+    }
+    std::atomic<int> order_failures{0};
+    std::atomic<int64_t> popped{0};
+    const int64_t total = (int64_t)num_producers * per_producer;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < num_producers; p++)
+    {
+        threads.emplace_back([&, p]() {
+            Backoff backoff;
+            for (int i = 0; i < per_producer; i++)
+            {
+                const uint64_t value = ((uint64_t)p << 32) | (uint32_t)i;
+                while (!queue.try_push(value))
+                {
+                    backoff.pause();
+                }
+                backoff.reset();
+            }
+        });
+    }
+    for (int c = 0; c < num_consumers; c++)
+    {
+        threads.emplace_back([&]() {
+            std::vector<int> last(num_producers, -1);
+            uint64_t value;
+            while (popped.load() < total)
+            {
+                if (!queue.try_pop(value))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                popped.fetch_add(1);
+                const int p = (int)(value >> 32);
+                const int i = (int)(value & 0xffffffffu);
+                if (i <= last[p])
+                {
+                    order_failures.fetch_add(1);
+                }
+                last[p] = i;
+                seen[(size_t)p * per_producer + i].fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    int failures = order_failures.load();
+    for (size_t i = 0; i < seen.size(); i++)
+    {
+        if (seen[i].load() != 1)
+        {
+            if (failures < 5)
+            {
+                std::cerr << "value " << (i / per_producer) << ":" << (i % per_producer) << " popped "
+                          << seen[i].load() << " times" << std::endl;
+            }
+            failures++;
+        }
+    }
+    uint64_t value;
+    if (queue.try_pop(value))
+    {
+        std::cerr << "queue not empty after all values were popped" << std::endl;
+        failures++;
+    }
+    if (failures != 0)
+    {
+        std::cerr << "queue " << num_producers << "P/" << num_consumers << "C capacity " << capacity << ": "
+                  << failures << " failures" << std::endl;
+    }
+    return failures;
+}
+
+// 出队后队列不再持有元素的引用，被丢弃或处理完的帧能立即释放
+static int check_release()
+{
+    LockFreeQueue<std::shared_ptr<int>> queue(4);
+    std::shared_ptr<int> item = std::make_shared<int>(1);
+    int failures = 0;
+    for (int round = 0; round < 10; round++)
+    {
+        queue.try_push(item);
+        std::shared_ptr<int> popped;
+        queue.try_pop(popped);
+        popped.reset();
+        if (item.use_count() != 1)
+        {
+            if (failures < 5)
+            {
+                std::cerr << "round " << round << ": queue still holds " << item.use_count() - 1 << " references"
+                    << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// 与bAsyncTask相同的结构：depth个任务槽位循环复用，多个线程以随机耗时乱序完成，
+// 单个线程用ReorderBuffer恢复顺序后回调，回调必须严格按提交顺序到达
+struct Job
+{
+    int64_t index = 0;
+};
+
+static int check_reorder(int depth, int num_workers, int num_jobs)
+{
+    typedef LockFreeQueue<Job*> JobQueue;
+    std::vector<Job> jobs(depth);
+    JobQueue free_queue(depth), work_queue(depth), done_queue(depth);
+    for (auto& job : jobs)
+    {
+        free_queue.try_push(&job);
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<int64_t> order;
+    order.reserve(num_jobs);
+    auto push = [](JobQueue& queue, Job* job) {
+        Backoff backoff;
+        while (!queue.try_push(job))
+        {
+            backoff.pause();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < num_workers; w++)
+    {
+        workers.emplace_back([&, w]() {
+            std::mt19937 rng(w + 1);
+            std::uniform_int_distribution<int> delay(0, 200);
+            Job* job;
+            while (!stop.load())
+            {
+                if (!work_queue.try_pop(job))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(delay(rng)));
+                push(done_queue, job);
+            }
+        });
+    }
+    std::thread tracker([&]() {
+        ReorderBuffer<Job> reorder(depth);
+        Job* job;
+        while (reorder.expected() < num_jobs)
+        {
+            if (!done_queue.try_pop(job))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            reorder.put(job->index, job, [&](Job* ready) {
+                order.push_back(ready->index);
+                push(free_queue, ready);
+            });
+        }
+    });
+
+    for (int64_t i = 0; i < num_jobs; i++)
+    {
+        Job* job;
+        Backoff backoff;
+        while (!free_queue.try_pop(job))
+        {
+            backoff.pause();
+        }
+        job->index = i;
+        push(work_queue, job);
+    }
+    tracker.join();
+    stop.store(true);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    int failures = order.size() == (size_t)num_jobs ? 0 : 1;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (order[i] != (int64_t)i)
+        {
+            if (failures < 5)
+            {
+                std::cerr << "reorder depth " << depth << ": callback " << i << " got frame " << order[i]
+                          << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char** argv)
+{
+    const int per_producer = argc > 1 ? atoi(argv[1]) : 200000;
+    int failures = 0;
+
+    failures += stress_queue(1, 1, per_producer, 2);
+    failures += stress_queue(4, 4, per_producer, 8);
+    failures += stress_queue(8, 2, per_producer / 4, 64);
+    failures += stress_queue(2, 8, per_producer / 4, 3);
+
+    failures += check_release();
+
+    failures += check_reorder(1, 3, 2000);
+    failures += check_reorder(4, 3, 5000);
+    failures += check_reorder(7, 6, 5000);
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "decoder.h"
+#include "model_bundle.h"
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+        g_failures++;
+    }
+}
+
+static std::vector<unsigned char> read_all(const std::string& path)
+{
+    std::vector<unsigned char> data;
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp)
+    {
+        return data;
+    }
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return data;
+}
+
+static void write_all(const std::string& path, const std::vector<unsigned char>& data)
+{
+    FILE* fp = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), fp);
+    fclose(fp);
+}
+
+// 模型包的写出、校验、元数据和加密段
+int main()
+{
+    const std::string path = "test_model_bundle.bin";
+    const unsigned char key[] = { 0x5a, 0x13, 0xc7 };
+
+    // crc32标准测试向量
+    check(bundle_crc32("123456789", 9) == 0xCBF43926u, "crc32 check value");
+    check(bundle_crc32("6789", 4, bundle_crc32("12345", 5)) == 0xCBF43926u, "crc32 incremental");
+
+    ModelMetadata metadata;
+    metadata.input_width = 640;
+    metadata.input_height = 384;
+    metadata.input_name = "images";
+    metadata.output_names = { "p3", "p4", "p5", "p6" };
+    metadata.strides = { 8, 16, 32, 64 };
+    metadata.class_names = { "person", "traffic light", "" };
+    std::vector<unsigned char> metadata_bytes;
+    encode_metadata(metadata, metadata_bytes);
+
+    ModelMetadata decoded;
+    check(decode_metadata(metadata_bytes.data(), metadata_bytes.size(), decoded), "decode metadata");
+    check(decoded.input_width == 640 && decoded.input_height == 384 && decoded.input_name == "images"
+        && decoded.output_names == metadata.output_names && decoded.strides == metadata.strides
+        && decoded.class_names == metadata.class_names && decoded.reg_max == 16, "metadata round trip");
+    check(!decode_metadata(metadata_bytes.data(), metadata_bytes.size() - 1, decoded), "truncated metadata");
+    {
+        // 改动任何一个字节都会被明文的crc32发现
+        std::vector<unsigned char> bad = metadata_bytes;
+        bad[bad.size() / 2] ^= 0x20;
+        check(!decode_metadata(bad.data(), bad.size(), decoded), "corrupted metadata detected");
+    }
+
+    // 解码器在栈上展开reg_max长度的分布，超出范围的reg_max和非正的stride不能进入解码器
+    {
+        std::vector<unsigned char> bytes;
+        ModelMetadata m = metadata;
+        m.reg_max = DECODE_MAX_REG_MAX;
+        encode_metadata(m, bytes);
+        check(decode_metadata(bytes.data(), bytes.size(), decoded) && decoded.reg_max == DECODE_MAX_REG_MAX,
+            "largest reg_max accepted");
+
+        const int bad_reg_max[] = { 0, -1, DECODE_MAX_REG_MAX + 1, 1 << 20 };
+        for (int reg_max : bad_reg_max)
+        {
+            m = metadata;
+            m.reg_max = reg_max;
+            encode_metadata(m, bytes);
+            check(!check_metadata(m) && !decode_metadata(bytes.data(), bytes.size(), decoded), "bad reg_max rejected");
+        }
+
+        const int bad_strides[] = { 0, -8 };
+        for (int stride : bad_strides)
+        {
+            m = metadata;
+            m.strides[1] = stride;
+            encode_metadata(m, bytes);
+            check(!check_metadata(m) && !decode_metadata(bytes.data(), bytes.size(), decoded), "bad stride rejected");
+        }
+
+        m = metadata;
+        m.strides.pop_back();
+        check(!check_metadata(m), "strides must match outputs");
+        m = metadata;
+        m.output_names.clear();
+        m.strides.clear();
+        encode_metadata(m, bytes);
+        check(!decode_metadata(bytes.data(), bytes.size(), decoded), "metadata without outputs rejected");
+    }
+
+    // 输出宽度放不下4*reg_max的分布或reg_max超出范围时，解码器不解码
+    {
+        std::vector<Object> proposals;
+        ncnn::Mat feat(64, 2, 2);
+        feat.fill(10.f);
+        decode_proposals(8, feat, 0.f, proposals, 16);
+        check(proposals.empty(), "output without class scores is skipped");
+        ncnn::Mat wide(4 * 40 + 2, 2, 2);
+        wide.fill(10.f);
+        decode_proposals(8, wide, 0.f, proposals, 40);
+        decode_proposals(8, wide, 0.f, proposals, 0);
+        check(proposals.empty(), "out of range reg_max is skipped");
+    }
+
+    std::string param_text = "7767517\n1 1\nInput in0 0 1 in0\n";
+    std::vector<unsigned char> param(param_text.begin(), param_text.end());
+    param.push_back(0);
+    std::vector<unsigned char> bin(100003);
+    for (size_t i = 0; i < bin.size(); i++)
+    {
+        bin[i] = (unsigned char)(i * 131 + 7);
+    }
+
+    std::vector<BundleSectionInput> sections = {
+        { BUNDLE_SECTION_METADATA, metadata_bytes.data(), metadata_bytes.size(), true },
+        { BUNDLE_SECTION_PARAM, param.data(), param.size(), false },
+        { BUNDLE_SECTION_BIN, bin.data(), bin.size(), true },
+    };
+    check(write_model_bundle(path.c_str(), sections, nullptr, 0) != 0, "encryption without key is rejected");
+    check(write_model_bundle(path.c_str(), sections, key, sizeof(key)) == 0, "write bundle");
+
+    {
+        ModelBundle bundle;
+        check(bundle.open(path.c_str()), "open bundle");
+        check(bundle.sections().size() == 3, "section count");
+        for (const auto& section : bundle.sections())
+        {
+            check(section.offset % BUNDLE_ALIGN == 0, "section alignment");
+        }
+
+        const BundleSection* p = bundle.find(BUNDLE_SECTION_PARAM);
+        check(p && p->size == param.size() && memcmp(bundle.section_data(*p), param.data(), param.size()) == 0,
+            "plain param section");
+
+        // 加密段可以直接交给MyEncryptedDataReader读取
+        const BundleSection* b = bundle.find(BUNDLE_SECTION_BIN);
+        check(b && (b->flags & BUNDLE_SECTION_ENCRYPTED), "bin section encrypted");
+        if (b)
+        {
+            check(memcmp(bundle.section_data(*b), bin.data(), 64) != 0, "bin stored encrypted");
+            MyEncryptedDataReader reader(bundle.section_data(*b), b->size, key, sizeof(key));
+            std::vector<unsigned char> out(bin.size());
+            size_t done = 0;
+            for (size_t n = 1; done < out.size(); n = n * 3 + 1)
+            {
+                size_t got = reader.read(out.data() + done, std::min(n, out.size() - done));
+                if (got == 0)
+                {
+                    break;
+                }
+                done += got;
+            }
+            check(done == bin.size() && out == bin, "decrypt bin section");
+        }
+
+        ModelMetadata read_back;
+        check(!bundle.read_metadata(read_back), "encrypted metadata needs key");
+        const unsigned char wrong_key[] = { 0x5a, 0x13, 0xc8 };
+        check(!bundle.read_metadata(read_back, wrong_key, sizeof(wrong_key)), "wrong key detected");
+        // 比元数据还长的密钥，只有task字符串中的一个字节解错，解析能通过，只能靠crc32发现
+        std::vector<unsigned char> long_key(192);
+        for (size_t i = 0; i < long_key.size(); i++)
+        {
+            long_key[i] = key[i % sizeof(key)];
+        }
+        long_key[9] ^= 0x20;
+        check(!bundle.read_metadata(read_back, long_key.data(), long_key.size()), "wrong key caught by crc32");
+        check(bundle.read_metadata(read_back, key, sizeof(key)) && read_back.class_names == metadata.class_names,
+            "read encrypted metadata");
+        check(!bundle.find(42), "missing section");
+    }
+
+    // 损坏的数据、段表和截断的文件都不能打开
+    const std::vector<unsigned char> good = read_all(path);
+    {
+        std::vector<unsigned char> bad = good;
+        bad[bad.size() / 2] ^= 1;
+        write_all(path, bad);
+        ModelBundle bundle;
+        check(!bundle.open(path.c_str()), "corrupted data detected");
+        check(bundle.open(path.c_str(), false), "header still valid without data verification");
+    }
+    {
+        std::vector<unsigned char> bad = good;
+        bad[bad.size() - 20] ^= 1;
+        write_all(path, bad);
+        ModelBundle bundle;
+        check(!bundle.open(path.c_str(), false), "corrupted section table detected");
+    }
+    {
+        std::vector<unsigned char> bad(good.begin(), good.end() - 1);
+        write_all(path, bad);
+        ModelBundle bundle;
+        check(!bundle.open(path.c_str(), false), "truncated bundle detected");
+    }
+    remove(path.c_str());
+
+    std::cout << (g_failures ? "FAILED" : "PASSED") << std::endl;
+    return g_failures != 0;
+}
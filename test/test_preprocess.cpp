@@ -0,0 +1,100 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include "preprocess.h"
+
+// 融合预处理与 from_pixels_resize + copy_make_border + substract_mean_normalize 的差异上限：
+// ncnn把缩放结果取整为uint8（0.5个灰度级）并使用11位定点权重，融合实现保持float，实测不超过0.8个灰度级
+static const float kTolerance = 1.f / 255.f;
+
+static int compare(int img_w, int img_h, int input_size, bool auto_, int stride_pad)
+{
+    const int stride = img_w * 3 + stride_pad;
+    std::mt19937 rng(img_w * 31 + img_h);
+    std::vector<unsigned char> bgr((size_t)stride * img_h);
+    for (auto& v : bgr)
+    {
+        v = (unsigned char)(rng() & 0xff);
+    }
+
+    const std::string name = std::to_string(img_w) + "x" + std::to_string(img_h) + (auto_ ? " auto" : "")
+        + (stride_pad ? " padded rows" : "");
+    const LetterboxInfo info = letterbox(img_w, img_h, input_size, input_size, auto_, true, 32);
+
+    ncnn::Mat resized = ncnn::Mat::from_pixels_resize(bgr.data(), ncnn::Mat::PIXEL_BGR2RGB, img_w, img_h, stride,
+        info.resized_w, info.resized_h);
+    ncnn::Mat expected;
+    ncnn::copy_make_border(resized, expected, info.top, info.dst_h - info.resized_h - info.top, info.left,
+        info.dst_w - info.resized_w - info.left, ncnn::BORDER_CONSTANT, 114.f);
+    const float norm_vals[3] = { 1 / 255.f, 1 / 255.f, 1 / 255.f };
+    expected.substract_mean_normalize(0, norm_vals);
+
+    LetterboxPreprocessor preprocessor;
+    ncnn::Mat actual;
+    preprocessor.run(bgr.data(), img_w, img_h, stride, info, actual);
+
+    if (actual.w != expected.w || actual.h != expected.h || actual.c != expected.c)
+    {
+        std::cerr << name << ": shape " << actual.w << "x" << actual.h
+            << "x" << actual.c << ", expected " << expected.w << "x" << expected.h << "x" << expected.c << std::endl;
+        return 1;
+    }
+
+    // 填充区域必须完全相同，图像区域在容差内
+    int failures = 0;
+    float max_diff = 0.f;
+    for (int q = 0; q < 3; q++)
+    {
+        for (int y = 0; y < actual.h; y++)
+        {
+            const float* a = actual.channel(q).row(y);
+            const float* e = expected.channel(q).row(y);
+            const bool pad_row = y < info.top || y >= info.top + info.resized_h;
+            for (int x = 0; x < actual.w; x++)
+            {
+                const bool pad = pad_row || x < info.left || x >= info.left + info.resized_w;
+                const float diff = std::fabs(a[x] - e[x]);
+                if (pad ? a[x] != e[x] : !(diff <= kTolerance))
+                {
+                    if (failures < 5)
+                    {
+                        std::cerr << name << ": channel " << q << " ("
+                            << x << ", " << y << ") " << a[x] * 255.f << " vs " << e[x] * 255.f
+                            << (pad ? " in padding" : "") << std::endl;
+                    }
+                    failures++;
+                }
+                if (!pad && diff > max_diff)
+                {
+                    max_diff = diff;
+                }
+            }
+        }
+    }
+    std::cout << name << " -> " << actual.w << "x" << actual.h
+        << ": max diff " << max_diff * 255.f << " levels" << std::endl;
+    return failures;
+}
+
+// 融合预处理的输出与ncnn逐步预处理的比较
+int main()
+{
+    const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 }, { 1001, 777 }, { 333, 1201 },
+        { 641, 479 }, { 7, 5 } };
+    int failures = 0;
+    for (auto size : sizes)
+    {
+        failures += compare(size[0], size[1], 640, false, 0);
+        failures += compare(size[0], size[1], 640, true, 0);
+        failures += compare(size[0], size[1], 640, true, 5);
+    }
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include "byte_track/BYTETracker.h"
+
+// 目标分成若干簇，簇内的框互相重叠，簇之间不相交，稀疏关联会拆出多个分量
+static void random_tlbrs(std::mt19937& rng, int n, int num_clusters, std::vector<float>& tlbrs)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    tlbrs.resize(n * 4);
+    for (int i = 0; i < n; i++)
+    {
+        const int c = (int)(uniform(rng) * num_clusters);
+        float* t = &tlbrs[i * 4];
+        t[0] = (c % 16) * 300.f + uniform(rng) * 60.f;
+        t[1] = (c / 16) * 300.f + uniform(rng) * 60.f;
+        t[2] = t[0] + 30.f + uniform(rng) * 60.f;
+        t[3] = t[1] + 30.f + uniform(rng) * 60.f;
+    }
+}
+
+// 重合的框：轨迹和检测都是同一个框的若干份拷贝，存在大量代价相等的最优解
+static void tied_tlbrs(std::mt19937& rng, int n, int num_shapes, std::vector<float>& tlbrs)
+{
+    std::uniform_int_distribution<int> shape(0, num_shapes - 1);
+    tlbrs.resize(n * 4);
+    for (int i = 0; i < n; i++)
+    {
+        const int s = shape(rng);
+        float* t = &tlbrs[i * 4];
+        t[0] = (s % 8) * 40.f;
+        t[1] = (s / 8) * 40.f;
+        t[2] = t[0] + 59.f;
+        t[3] = t[1] + 59.f;
+    }
+}
+
+static void cost_matrix(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& cost)
+{
+    const int rows = (int)a.size() / 4;
+    const int cols = (int)b.size() / 4;
+    cost.resize((size_t)rows * cols);
+    for (int n = 0; n < rows; n++)
+    {
+        for (int k = 0; k < cols; k++)
+        {
+            cost[(size_t)n * cols + k] = tlbr_iou_distance(&a[n * 4], &b[k * 4]);
+        }
+    }
+}
+
+// 检查匹配合法，返回匹配数，total为匹配上的代价之和
+static int check_solution(const char* name, const std::vector<float>& cost, int rows, int cols, float thresh,
+    const std::vector<int>& rowsol, const std::vector<int>& colsol, double& total, int& failures)
+{
+    int count = 0;
+    total = 0;
+    for (int i = 0; i < rows; i++)
+    {
+        const int j = rowsol[i];
+        if (j < 0)
+        {
+            continue;
+        }
+        if (j >= cols || colsol[j] != i || cost[(size_t)i * cols + j] >= thresh)
+        {
+            if (failures < 10)
+            {
+                std::cerr << name << ": invalid match (" << i << ", " << j << ")" << std::endl;
+            }
+            failures++;
+            continue;
+        }
+        total += cost[(size_t)i * cols + j];
+        count++;
+    }
+    for (int j = 0; j < cols; j++)
+    {
+        if (colsol[j] >= 0 && rowsol[colsol[j]] != j)
+        {
+            if (failures < 10)
+            {
+                std::cerr << name << ": column " << j << " inconsistent" << std::endl;
+            }
+            failures++;
+        }
+    }
+    return count;
+}
+
+// 稀疏分解与稠密LapSolver比较：随机场景最优解唯一，匹配逐个相同；重合场景只要求匹配数和总代价相同
+static int compare_solvers(int num_threads)
+{
+    std::mt19937 rng(11);
+    LapSolver dense;
+    SparseAssociation sparse;
+    std::vector<float> atlbrs, btlbrs, cost;
+    std::vector<int> dense_rowsol, dense_colsol, sparse_rowsol, sparse_colsol;
+    const float threshes[] = { 0.5f, 0.8f, 0.9f };
+    int failures = 0;
+
+    for (int round = 0; round < 200; round++)
+    {
+        const bool tied = round % 2 == 1;
+        const int rows = (round * 7) % 150;
+        const int cols = (round * 13) % 170;
+        const float thresh = threshes[round % 3];
+        if (tied)
+        {
+            tied_tlbrs(rng, rows, 1 + round % 12, atlbrs);
+            tied_tlbrs(rng, cols, 1 + round % 12, btlbrs);
+        }
+        else
+        {
+            random_tlbrs(rng, rows, 1 + round % 40, atlbrs);
+            random_tlbrs(rng, cols, 1 + round % 40, btlbrs);
+        }
+        cost_matrix(atlbrs, btlbrs, cost);
+
+        dense.solve(cost.data(), rows, cols, dense_rowsol, dense_colsol, thresh);
+        sparse.solve(atlbrs.data(), rows, btlbrs.data(), cols, thresh, sparse_rowsol, sparse_colsol, num_threads);
+
+        double dense_total, sparse_total;
+        const int dense_count = check_solution("dense", cost, rows, cols, thresh, dense_rowsol, dense_colsol,
+            dense_total, failures);
+        const int sparse_count = check_solution("sparse", cost, rows, cols, thresh, sparse_rowsol, sparse_colsol,
+            sparse_total, failures);
+
+        bool same;
+        if (tied)
+        {
+            same = dense_count == sparse_count && std::fabs(dense_total - sparse_total) <= 1e-6 * (1 + dense_count);
+        }
+        else
+        {
+            same = dense_rowsol == sparse_rowsol && dense_colsol == sparse_colsol;
+        }
+        if (!same)
+        {
+            if (failures < 10)
+            {
+                std::cerr << (tied ? "tied" : "random") << " " << rows << "x" << cols << " thresh " << thresh
+                    << " (" << num_threads << " threads): dense " << dense_count << " matches / " << dense_total
+                    << ", sparse " << sparse_count << " matches / " << sparse_total << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// 几百个目标的连续帧，目标位置带噪声，不存在代价相等的配对
+static void make_frame(std::mt19937& rng, int frame, int num_objects, std::vector<Object>& objects)
+{
+    std::normal_distribution<float> noise(0.f, 1.5f);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        if ((frame + i * 11) % 70 < 3)
+        {
+            continue;
+        }
+        const float t = 0.03f * frame;
+        Object obj;
+        obj.rect.x = 50.f + (i % 25) * 75.f + 25.f * std::cos(t + i) + noise(rng);
+        obj.rect.y = 40.f + (i / 25) * 80.f + 25.f * std::sin(t + i) + noise(rng);
+        obj.rect.width = 45.f + (i % 5) * 4.f + noise(rng);
+        obj.rect.height = 55.f + (i % 7) * 3.f + noise(rng);
+        obj.prob = uniform(rng) < 0.15f ? 0.3f : 0.85f;
+        obj.label = i % 3;
+        objects.push_back(obj);
+    }
+}
+
+// 同一序列分别强制走稠密和稀疏关联，两个跟踪器每帧的输出完全相同
+static int compare_trackers(int num_objects, int num_frames)
+{
+    BYTETracker dense_tracker(30, 30);
+    BYTETracker sparse_tracker(30, 30);
+    dense_tracker.set_dense_max_pairs(std::numeric_limits<long long>::max());
+    sparse_tracker.set_dense_max_pairs(0);
+
+    std::mt19937 rng(num_objects);
+    std::vector<Object> objects;
+    std::vector<const STrack*> dense_output, sparse_output;
+    int failures = 0;
+    for (int f = 0; f < num_frames; f++)
+    {
+        make_frame(rng, f, num_objects, objects);
+        dense_tracker.update(objects, dense_output);
+        sparse_tracker.update(objects, sparse_output);
+
+        bool same = dense_output.size() == sparse_output.size();
+        for (size_t i = 0; same && i < dense_output.size(); i++)
+        {
+            same = dense_output[i]->track_id == sparse_output[i]->track_id
+                && memcmp(dense_output[i]->tlbr, sparse_output[i]->tlbr, sizeof(dense_output[i]->tlbr)) == 0;
+        }
+        if (!same)
+        {
+            if (failures < 5)
+            {
+                std::cerr << num_objects << " objects: frame " << f << " differs, dense " << dense_output.size()
+                    << " tracks, sparse " << sparse_output.size() << " tracks" << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// 稀疏关联与稠密关联的结果比较
+int main()
+{
+    int failures = 0;
+    failures += compare_solvers(1);
+    failures += compare_solvers(4);
+    failures += compare_trackers(20, 200);
+    failures += compare_trackers(300, 200);
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include "byte_track/BYTETracker.h"
+
+// 目标不断出现和消失，轨迹槽位反复回收复用
+static void make_frame(int frame, int num_objects, std::vector<Object>& objects)
+{
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        const int life = 50 + (i * 17) % 90;
+        const int phase = (frame + i * 31) % (life + 40);
+        if (phase >= life)
+        {
+            continue;
+        }
+        // 每次重新出现的位置不同，生成新的轨迹
+        const int round = (frame + i * 31) / (life + 40);
+        Object obj;
+        obj.rect.x = 50.f + (i % 12) * 150.f + (round % 3) * 40.f + 0.5f * phase;
+        obj.rect.y = 50.f + (i / 12) * 140.f + 20.f * std::sin(0.03f * phase);
+        obj.rect.width = 40.f + (i % 4) * 6.f;
+        obj.rect.height = 70.f + (i % 3) * 5.f;
+        obj.prob = (frame + i) % 13 == 0 ? 0.3f : 0.8f;
+        obj.label = 0;
+        objects.push_back(obj);
+    }
+}
+
+// 长时间运行：句柄在轨迹存活期间指向同一个对象，回收后失效；槽位数不随运行时间增长；
+// 句柄输出与指针输出一致
+int main(int argc, char** argv)
+{
+    const int num_objects = argc > 1 ? atoi(argv[1]) : 120;
+    const int num_frames = argc > 2 ? atoi(argv[2]) : 20000;
+
+    BYTETracker tracker(30, 30);
+    BYTETracker reference(30, 30);
+    std::vector<Object> objects;
+    std::vector<TrackHandle> handles;
+    std::vector<const STrack*> output;
+
+    struct Seen
+    {
+        TrackHandle handle;
+        const STrack* track;
+    };
+    std::map<int, Seen> seen; // track_id -> 第一次输出时的句柄和地址
+    int failures = 0;
+    int expired = 0;
+    int max_index_warmup = -1;
+    int max_index = -1;
+
+    for (int f = 0; f < num_frames; f++)
+    {
+        make_frame(f, num_objects, objects);
+        tracker.update(objects, handles);
+        reference.update(objects, output);
+
+        if (handles.size() != output.size())
+        {
+            failures++;
+            continue;
+        }
+        for (size_t i = 0; i < handles.size(); i++)
+        {
+            const STrack* track = tracker.get_track(handles[i]);
+            if (!track || track->track_id != output[i]->track_id
+                || memcmp(track->tlbr, output[i]->tlbr, sizeof(track->tlbr)) != 0)
+            {
+                if (failures < 5)
+                {
+                    std::cerr << "frame " << f << ": handle output differs from pointer output" << std::endl;
+                }
+                failures++;
+                continue;
+            }
+            auto it = seen.find(track->track_id);
+            if (it == seen.end())
+            {
+                Seen s = { handles[i], track };
+                seen[track->track_id] = s;
+            }
+            else if (it->second.track != track || it->second.handle.index != handles[i].index
+                || it->second.handle.generation != handles[i].generation)
+            {
+                if (failures < 5)
+                {
+                    std::cerr << "frame " << f << ": track " << track->track_id << " moved" << std::endl;
+                }
+                failures++;
+            }
+            max_index = std::max(max_index, handles[i].index);
+        }
+
+        // 之前发出的句柄：要么仍然指向同一条轨迹，要么已经失效
+        for (auto it = seen.begin(); it != seen.end();)
+        {
+            const STrack* track = tracker.get_track(it->second.handle);
+            if (!track)
+            {
+                expired++;
+                it = seen.erase(it);
+                continue;
+            }
+            if (track->track_id != it->first)
+            {
+                if (failures < 5)
+                {
+                    std::cerr << "frame " << f << ": stale handle of track " << it->first << " resolved to track "
+                        << track->track_id << std::endl;
+                }
+                failures++;
+            }
+            ++it;
+        }
+
+        if (f == num_frames / 10)
+        {
+            max_index_warmup = max_index;
+        }
+    }
+
+    std::cout << "frames: " << num_frames << ", expired handles: " << expired << ", max slot: " << max_index
+        << " (after warmup: " << max_index_warmup << ")" << std::endl;
+    if (expired == 0)
+    {
+        std::cerr << "no track was recycled" << std::endl;
+        failures++;
+    }
+    // 槽位数由同时存在的最大轨迹数决定，预热后不应再明显增长
+    if (max_index > max_index_warmup + num_objects / 4)
+    {
+        std::cerr << "track pool keeps growing" << std::endl;
+        failures++;
+    }
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
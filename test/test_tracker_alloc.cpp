@@ -0,0 +1,146 @@
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "byte_track/BYTETracker.h"
+
+// 统计全局operator new的调用次数
+static std::atomic<long long> g_alloc_count(0);
+static std::atomic<bool> g_counting(false);
+
+void* operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// 周期性的合成场景：目标沿椭圆轨迹运动，周期性漏检和低分，另有少量杂波
+static void make_frame(int frame, int num_objects, std::vector<Object>& objects)
+{
+    const int period = 240;
+    const float t = 2.f * 3.1415926f * (frame % period) / period;
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        if ((frame + i * 7) % 60 < 2)
+        {
+            continue;
+        }
+        Object obj;
+        obj.rect.x = 100.f + (i % 20) * 90.f + 30.f * std::cos(t + i);
+        obj.rect.y = 80.f + (i / 20) * 60.f + 20.f * std::sin(t + i);
+        obj.rect.width = 40.f + (i % 5) * 4.f;
+        obj.rect.height = 50.f + (i % 7) * 3.f;
+        obj.prob = (frame + i) % 9 == 0 ? 0.3f : 0.8f;
+        obj.label = i % 3;
+        objects.push_back(obj);
+    }
+    for (int c = 0; c < frame % 3; c++)
+    {
+        Object obj;
+        obj.rect = cv::Rect_<float>(1900.f + c * 50.f, 1000.f, 20.f, 20.f);
+        obj.prob = 0.6f;
+        obj.label = 1;
+        objects.push_back(obj);
+    }
+}
+
+// 预热若干周期后，BYTETracker::update(objects, output)和update_tracks都不应再分配内存，
+// update_tracks返回的视图与指针输出一致
+int main(int argc, char** argv)
+{
+    const int num_objects = argc > 1 ? atoi(argv[1]) : 300;
+    const int warmup_frames = 240 * 3;
+    const int test_frames = 240 * 2;
+
+    BYTETracker tracker(30, 30);
+    BYTETracker view_tracker(30, 30);
+    std::vector<Object> objects;
+    std::vector<const STrack*> output;
+    objects.reserve(num_objects + 8);
+
+    for (int f = 0; f < warmup_frames; f++)
+    {
+        make_frame(f, num_objects, objects);
+        tracker.update(objects, output);
+        view_tracker.update_tracks(objects);
+    }
+
+    size_t total = 0;
+    long long allocs = 0;
+    int mismatches = 0;
+    for (int f = warmup_frames; f < warmup_frames + test_frames; f++)
+    {
+        make_frame(f, num_objects, objects);
+
+        g_alloc_count.store(0);
+        g_counting.store(true);
+        tracker.update(objects, output);
+        TrackSpan view = view_tracker.update_tracks(objects);
+        size_t visited = 0;
+        view_tracker.visit_active_tracks([&visited](const STrack&) { visited++; });
+        g_counting.store(false);
+
+        allocs += g_alloc_count.load();
+        total += output.size();
+
+        bool same = view.size() == output.size() && visited == view.size();
+        size_t i = 0;
+        for (const STrack& track : view)
+        {
+            same = same && i < output.size() && track.track_id == output[i]->track_id
+                && track.tlbr[0] == output[i]->tlbr[0] && track.tlbr[3] == output[i]->tlbr[3];
+            i++;
+        }
+        mismatches += same ? 0 : 1;
+    }
+
+    std::cout << "objects: " << num_objects << ", frames: " << test_frames << ", tracks: " << total
+        << ", allocations: " << allocs << std::endl;
+    if (allocs != 0)
+    {
+        std::cerr << "FAILED: update allocated memory in steady state" << std::endl;
+        return 1;
+    }
+    if (mismatches != 0)
+    {
+        std::cerr << "FAILED: track view differs from update output in " << mismatches << " frames" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include "byte_track/BYTETrackerGroup.h"
+
+struct TrackRecord
+{
+    int frame;
+    int id;
+    float tlbr[4];
+
+    bool operator==(const TrackRecord& other) const
+    {
+        return frame == other.frame && id == other.id && memcmp(tlbr, other.tlbr, sizeof(tlbr)) == 0;
+    }
+};
+
+typedef std::vector<std::vector<TrackRecord> > StreamRecords;
+
+// 第stream路第frame帧的检测结果，只由(stream, frame)决定；各路目标数不同，线程之间负载不均
+static void make_frame(int stream, int frame, std::vector<Object>& objects)
+{
+    std::mt19937 rng(stream * 100003 + frame);
+    std::normal_distribution<float> noise(0.f, 1.5f);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    const int num_objects = 5 + (stream * 37) % 120;
+    objects.clear();
+    for (int i = 0; i < num_objects; i++)
+    {
+        // 每个目标存活一段时间后消失，之后由新目标代替
+        const int life = 90 + (i * 13 + stream) % 120;
+        const int phase = (frame + i * 29) % (life + 20);
+        if (phase >= life || uniform(rng) < 0.05f)
+        {
+            continue;
+        }
+        const float t = 0.02f * phase;
+        Object obj;
+        obj.rect.x = 60.f + (i % 16) * 110.f + 40.f * std::cos(t + i) + noise(rng);
+        obj.rect.y = 40.f + (i / 16) * 120.f + 30.f * std::sin(t + i) + noise(rng);
+        obj.rect.width = 40.f + (i % 5) * 5.f + noise(rng);
+        obj.rect.height = 60.f + (i % 7) * 4.f + noise(rng);
+        obj.prob = uniform(rng) < 0.1f ? 0.3f : 0.85f;
+        obj.label = i % 3;
+        objects.push_back(obj);
+    }
+}
+
+static void record(int frame, const std::vector<const STrack*>& output, std::vector<TrackRecord>& records)
+{
+    for (size_t i = 0; i < output.size(); i++)
+    {
+        TrackRecord r;
+        r.frame = frame;
+        r.id = output[i]->track_id;
+        memcpy(r.tlbr, output[i]->tlbr, sizeof(r.tlbr));
+        records.push_back(r);
+    }
+}
+
+// 逐路串行更新独立的跟踪器，作为参照结果
+static double run_sequential(int num_streams, int num_frames, StreamRecords& records)
+{
+    std::vector<std::unique_ptr<BYTETracker> > trackers;
+    for (int k = 0; k < num_streams; k++)
+    {
+        trackers.emplace_back(new BYTETracker(30, 30));
+        trackers[k]->set_track_ids(k + 1, num_streams);
+    }
+    records.assign(num_streams, std::vector<TrackRecord>());
+    std::vector<std::vector<Object> > objects(num_streams);
+    std::vector<const STrack*> output;
+    double ms = 0;
+    for (int f = 0; f < num_frames; f++)
+    {
+        for (int k = 0; k < num_streams; k++)
+        {
+            make_frame(k, f, objects[k]);
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int k = 0; k < num_streams; k++)
+        {
+            trackers[k]->update(objects[k], output);
+            record(f, output, records[k]);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return ms;
+}
+
+// 跟踪器组并行更新，shared_ids非空时所有跟踪器共用这个生成器
+static double run_group(int num_streams, int num_frames, int num_threads, TrackIdMode id_mode,
+    TrackIdGenerator* shared_ids, StreamRecords& records)
+{
+    BYTETrackerGroup group(num_streams, 30, 30, num_threads, id_mode);
+    if (shared_ids)
+    {
+        for (int k = 0; k < num_streams; k++)
+        {
+            group.tracker(k).set_id_generator(shared_ids);
+        }
+    }
+    records.assign(num_streams, std::vector<TrackRecord>());
+    std::vector<std::vector<Object> > objects(num_streams);
+    std::vector<std::vector<const STrack*> > outputs;
+    double ms = 0;
+    for (int f = 0; f < num_frames; f++)
+    {
+        for (int k = 0; k < num_streams; k++)
+        {
+            make_frame(k, f, objects[k]);
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        group.update(objects, outputs);
+        auto end = std::chrono::high_resolution_clock::now();
+        ms += std::chrono::duration<double, std::milli>(end - start).count();
+        for (int k = 0; k < num_streams; k++)
+        {
+            record(f, outputs[k], records[k]);
+        }
+    }
+    return ms;
+}
+
+// 比较两次运行的结果，id_map把b中的id换算成a中的id
+template <typename IdMap>
+static int compare(const char* name, const StreamRecords& a, const StreamRecords& b, IdMap id_map)
+{
+    int failures = 0;
+    for (size_t k = 0; k < a.size(); k++)
+    {
+        bool same = a[k].size() == b[k].size();
+        for (size_t i = 0; same && i < a[k].size(); i++)
+        {
+            TrackRecord r = b[k][i];
+            r.id = id_map((int)k, r.id);
+            same = a[k][i] == r;
+        }
+        if (!same)
+        {
+            if (failures < 5)
+            {
+                std::cerr << name << ": stream " << k << " differs from the sequential run" << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// 每帧内id不重复；owner记录每个id属于哪一路，不同路出现相同id时报错
+static int check_unique(const char* name, const StreamRecords& records, std::map<int, int>& owner)
+{
+    int failures = 0;
+    owner.clear();
+    for (size_t k = 0; k < records.size(); k++)
+    {
+        std::set<int> frame_ids;
+        int frame = -1;
+        for (size_t i = 0; i < records[k].size(); i++)
+        {
+            const TrackRecord& r = records[k][i];
+            if (r.frame != frame)
+            {
+                frame_ids.clear();
+                frame = r.frame;
+            }
+            bool ok = frame_ids.insert(r.id).second;
+            auto it = owner.insert(std::make_pair(r.id, (int)k)).first;
+            ok = ok && it->second == (int)k;
+            if (!ok)
+            {
+                if (failures < 5)
+                {
+                    std::cerr << name << ": id " << r.id << " duplicated in stream " << k << " frame " << r.frame
+                        << std::endl;
+                }
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+// 64路并行更新：id在组内唯一，结果与线程数、调度无关且与串行更新一致
+int main(int argc, char** argv)
+{
+    const int num_streams = 64;
+    const int num_frames = argc > 1 ? atoi(argv[1]) : 300;
+    const int num_threads = argc > 2 ? atoi(argv[2]) : 8;
+    int failures = 0;
+
+    StreamRecords sequential, parallel, repeat, per_tracker, shared;
+    const double seq_ms = run_sequential(num_streams, num_frames, sequential);
+    const double par_ms = run_group(num_streams, num_frames, num_threads, TrackIdMode::GroupUnique, nullptr, parallel);
+    run_group(num_streams, num_frames, 3, TrackIdMode::GroupUnique, nullptr, repeat);
+    run_group(num_streams, num_frames, num_threads, TrackIdMode::PerTracker, nullptr, per_tracker);
+    TrackIdGenerator shared_ids;
+    run_group(num_streams, num_frames, num_threads, TrackIdMode::PerTracker, &shared_ids, shared);
+
+    size_t total = 0;
+    for (int k = 0; k < num_streams; k++)
+    {
+        total += sequential[k].size();
+    }
+    std::cout << num_streams << " streams x " << num_frames << " frames, tracks: " << total << std::endl;
+    std::cout << "sequential: " << seq_ms / num_frames << " ms/frame, group(" << num_threads << " threads): "
+        << par_ms / num_frames << " ms/frame" << std::endl;
+
+    auto same_id = [](int, int id) { return id; };
+    failures += compare("group", sequential, parallel, same_id);
+    failures += compare("group(3 threads)", sequential, repeat, same_id);
+    // 每路独立计数时第n个id为n + 1，对应组内唯一模式下的 k + 1 + n * K
+    failures += compare("per tracker", sequential, per_tracker,
+        [&](int k, int id) { return k + 1 + (id - 1) * num_streams; });
+
+    std::map<int, int> owner;
+    failures += check_unique("group", parallel, owner);
+    for (auto it = owner.begin(); it != owner.end(); ++it)
+    {
+        if ((it->first - 1) % num_streams != it->second)
+        {
+            std::cerr << "group: id " << it->first << " outside the id range of stream " << it->second << std::endl;
+            failures++;
+            break;
+        }
+    }
+
+    // 共用一个生成器时id分配顺序取决于调度，只检查唯一性；每路的id与串行结果一一对应，框完全一致
+    failures += check_unique("shared generator", shared, owner);
+    std::vector<std::map<int, int> > id_maps(num_streams);
+    for (int k = 0; k < num_streams; k++)
+    {
+        for (size_t i = 0; i < shared[k].size() && i < sequential[k].size(); i++)
+        {
+            id_maps[k].insert(std::make_pair(shared[k][i].id, sequential[k][i].id));
+        }
+    }
+    failures += compare("shared generator", sequential, shared,
+        [&](int k, int id) { return id_maps[k][id]; });
+
+    if (failures != 0)
+    {
+        std::cerr << "FAILED: " << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "decoder.h"
+#include "model_bundle.h"
+
+static bool read_file(const std::string& path, std::vector<unsigned char>& data)
+{
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp)
+    {
+        return false;
+    }
+    data.clear();
+    unsigned char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+static std::string trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+    {
+        return std::string();
+    }
+    size_t end = s.find_last_not_of(" \t\r\n");
+    std::string v = s.substr(begin, end - begin + 1);
+    // 去掉引号
+    if (v.size() >= 2 && (v[0] == '\'' || v[0] == '"') && v.back() == v[0])
+    {
+        v = v.substr(1, v.size() - 2);
+    }
+    return v;
+}
+
+// 只解析ultralytics导出的metadata.yaml中用到的字段：task、stride、imgsz、names
+static bool parse_metadata_yaml(const std::string& path, ModelMetadata& metadata, int& max_stride)
+{
+    std::vector<unsigned char> data;
+    if (!read_file(path, data))
+    {
+        return false;
+    }
+    std::istringstream in(std::string(data.begin(), data.end()));
+    std::string line, section;
+    std::vector<int> imgsz;
+    while (std::getline(in, line))
+    {
+        if (trim(line).empty())
+        {
+            continue;
+        }
+        const bool nested = line[0] == ' ' || line[0] == '-';
+        if (!nested)
+        {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                continue;
+            }
+            section = line.substr(0, colon);
+            std::string value = trim(line.substr(colon + 1));
+            if (section == "task")
+            {
+                metadata.task = value;
+            }
+            else if (section == "stride")
+            {
+                max_stride = atoi(value.c_str());
+            }
+            continue;
+        }
+        std::string item = trim(line);
+        if (section == "imgsz" && item[0] == '-')
+        {
+            imgsz.push_back(atoi(item.c_str() + 1));
+        }
+        else if (section == "names")
+        {
+            size_t colon = item.find(':');
+            if (colon == std::string::npos)
+            {
+                continue;
+            }
+            int id = atoi(item.c_str());
+            if (id < 0)
+            {
+                continue;
+            }
+            if ((int)metadata.class_names.size() <= id)
+            {
+                metadata.class_names.resize(id + 1);
+            }
+            metadata.class_names[id] = trim(item.substr(colon + 1));
+        }
+    }
+    if (imgsz.size() == 2)
+    {
+        metadata.input_height = imgsz[0];
+        metadata.input_width = imgsz[1];
+    }
+    else if (imgsz.size() == 1)
+    {
+        metadata.input_height = metadata.input_width = imgsz[0];
+    }
+    return true;
+}
+
+// 从param中找出Input层的输出作为输入名，没有被任何层使用的blob作为输出名
+static bool parse_param_io(const std::vector<unsigned char>& param, ModelMetadata& metadata)
+{
+    std::istringstream in(std::string(param.begin(), param.end()));
+    int magic = 0, layer_count = 0, blob_count = 0;
+    in >> magic >> layer_count >> blob_count;
+    if (!in || magic != 7767517)
+    {
+        return false;
+    }
+    std::string line;
+    std::getline(in, line);
+    std::vector<std::string> produced;
+    std::set<std::string> consumed;
+    std::string input_name;
+    for (int i = 0; i < layer_count && std::getline(in, line);)
+    {
+        std::istringstream ls(line);
+        std::string type, name;
+        int bottom_count = 0, top_count = 0;
+        if (!(ls >> type >> name >> bottom_count >> top_count))
+        {
+            continue;
+        }
+        i++;
+        std::string blob;
+        for (int j = 0; j < bottom_count && ls >> blob; j++)
+        {
+            consumed.insert(blob);
+        }
+        for (int j = 0; j < top_count && ls >> blob; j++)
+        {
+            produced.push_back(blob);
+            if (type == "Input" && input_name.empty())
+            {
+                input_name = blob;
+            }
+        }
+    }
+    std::vector<std::string> outputs;
+    for (const auto& blob : produced)
+    {
+        if (!consumed.count(blob) && blob != input_name)
+        {
+            outputs.push_back(blob);
+        }
+    }
+    // out0 < out1 < ... < out10
+    std::sort(outputs.begin(), outputs.end(), [](const std::string& a, const std::string& b)
+    {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    if (input_name.empty() || outputs.empty())
+    {
+        return false;
+    }
+    metadata.input_name = input_name;
+    metadata.output_names = outputs;
+    return true;
+}
+
+static bool parse_key(const std::string& hex, std::vector<unsigned char>& key)
+{
+    if (hex.empty() || hex.size() % 2 != 0)
+    {
+        return false;
+    }
+    key.clear();
+    for (size_t i = 0; i < hex.size(); i += 2)
+    {
+        char byte[3] = { hex[i], hex[i + 1], 0 };
+        char* end = nullptr;
+        key.push_back((unsigned char)strtoul(byte, &end, 16));
+        if (*end != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void usage()
+{
+    std::cerr << "usage: pack_model_bundle <model_dir> <output> [--key hex] [--encrypt param,bin,metadata] "
+        "[--reg-max n]\n"
+        "  model_dir contains model.ncnn.param, model.ncnn.bin and metadata.yaml\n"
+        "  --key hex      xor key, e.g. 5a or 5a13c7 for a key stream\n"
+        "  --encrypt      sections to encrypt, default param,bin when a key is given" << std::endl;
+}
+
+// 把ultralytics导出的ncnn模型目录打包成一个模型包
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        usage();
+        return 1;
+    }
+    const std::string dir = argv[1];
+    const std::string output = argv[2];
+    std::vector<unsigned char> key;
+    std::string encrypt;
+    ModelMetadata metadata;
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--key") == 0)
+        {
+            if (!parse_key(argv[i + 1], key))
+            {
+                std::cerr << "bad key " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--encrypt") == 0)
+        {
+            encrypt = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--reg-max") == 0)
+        {
+            metadata.reg_max = atoi(argv[i + 1]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (!key.empty() && encrypt.empty())
+    {
+        encrypt = "param,bin";
+    }
+    auto encrypted = [&](const char* name)
+    {
+        return ("," + encrypt + ",").find(std::string(",") + name + ",") != std::string::npos;
+    };
+
+    std::vector<unsigned char> param, bin;
+    if (!read_file(dir + "/model.ncnn.param", param) || !read_file(dir + "/model.ncnn.bin", bin))
+    {
+        std::cerr << "read " << dir << "/model.ncnn.param or model.ncnn.bin failed" << std::endl;
+        return 1;
+    }
+    // 末尾加0，加载时可以直接在映射上load_param_mem
+    param.push_back(0);
+
+    int max_stride = 32;
+    if (!parse_metadata_yaml(dir + "/metadata.yaml", metadata, max_stride))
+    {
+        std::cerr << "read " << dir << "/metadata.yaml failed, using defaults" << std::endl;
+    }
+    if (!parse_param_io(param, metadata))
+    {
+        std::cerr << "parse " << dir << "/model.ncnn.param failed" << std::endl;
+        return 1;
+    }
+    // 检测头的stride从大到小每次减半，3个输出为8/16/32
+    metadata.strides.clear();
+    for (size_t i = 0; i < metadata.output_names.size(); i++)
+    {
+        metadata.strides.push_back(max_stride >> (metadata.output_names.size() - 1 - i));
+    }
+
+    if (!check_metadata(metadata))
+    {
+        std::cerr << "invalid metadata: reg_max must be 1.." << DECODE_MAX_REG_MAX
+            << ", strides must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<unsigned char> metadata_bytes;
+    encode_metadata(metadata, metadata_bytes);
+
+    std::vector<BundleSectionInput> sections = {
+        { BUNDLE_SECTION_METADATA, metadata_bytes.data(), metadata_bytes.size(), encrypted("metadata") },
+        { BUNDLE_SECTION_PARAM, param.data(), param.size(), encrypted("param") },
+        { BUNDLE_SECTION_BIN, bin.data(), bin.size(), encrypted("bin") },
+    };
+    if (write_model_bundle(output.c_str(), sections, key.data(), key.size()) != 0)
+    {
+        return 1;
+    }
+
+    // 重新打开校验一遍
+    ModelBundle bundle;
+    ModelMetadata check;
+    if (!bundle.open(output.c_str()) || !bundle.read_metadata(check, key.data(), key.size()))
+    {
+        std::cerr << "verify " << output << " failed" << std::endl;
+        return 1;
+    }
+    printf("%s: task %s, input %s %dx%d, %zu classes, reg_max %d\n", output.c_str(), check.task.c_str(),
+        check.input_name.c_str(), check.input_width, check.input_height, check.class_names.size(), check.reg_max);
+    for (size_t i = 0; i < check.output_names.size(); i++)
+    {
+        printf("  output %s stride %d\n", check.output_names[i].c_str(), check.strides[i]);
+    }
+    for (const auto& section : bundle.sections())
+    {
+        printf("  section %u offset %llu size %llu crc32 %08x%s\n", section.type,
+            (unsigned long long)section.offset, (unsigned long long)section.size, section.crc32,
+            section.flags & BUNDLE_SECTION_ENCRYPTED ? " encrypted" : "");
+    }
+    return 0;
+}